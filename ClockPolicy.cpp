@@ -0,0 +1,9 @@
+#include "ClockPolicy.hpp"
+
+std::chrono::milliseconds getChronoSteadyClockTicks(void)
+{
+    auto now = std::chrono::steady_clock::now(); // should be nanoseconds -> cast to milliseconds
+    auto duration = now.time_since_epoch();
+    auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(duration);
+    return millis;
+}
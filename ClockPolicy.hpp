@@ -0,0 +1,72 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#ifdef __linux__
+#include <time.h>
+#endif
+
+/** steady clock truncated to milliseconds, default time source of the millisecond timer managers.
+ * Use SteadyClockPolicy for finer resolutions */
+extern std::chrono::milliseconds getChronoSteadyClockTicks(void);
+
+/* Clock policies of BasicTimerManager. A policy is a copyable type with
+ *     SomeDuration now() const;
+ * returning a steady time in any std::chrono::duration. The manager converts it to its own resolution.
+ * The manager and its detached timers keep a copy and call it directly, so stateless policies inline to a single
+ * clock read. */
+
+/** std::chrono::steady_clock in its native resolution */
+struct SteadyClockPolicy
+{
+    std::chrono::steady_clock::duration now() const
+    {
+        return std::chrono::steady_clock::now().time_since_epoch();
+    }
+};
+
+#ifdef __linux__
+/** CLOCK_MONOTONIC_COARSE: no system call, but only as precise as the kernel tick (1-10ms) */
+struct CoarseMonotonicClockPolicy
+{
+    std::chrono::nanoseconds now() const
+    {
+        timespec time;
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &time);
+        return std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec);
+    }
+};
+#endif
+
+/** Type erased clock, any callable returning Duration. By default the steady clock */
+template <typename Duration>
+class BasicFunctionClockPolicy
+{
+public:
+    using SteadyTickCallbackType = std::function<Duration(void)>;
+
+    BasicFunctionClockPolicy()
+    : m_steadyTickProvider([]() {
+        return std::chrono::duration_cast<Duration>(std::chrono::steady_clock::now().time_since_epoch());
+    })
+    {}
+
+    template <typename Provider,
+              typename = std::enable_if_t<not std::is_same<std::decay_t<Provider>, BasicFunctionClockPolicy>::value>>
+    BasicFunctionClockPolicy(Provider&& steadyTickProvider)
+    : m_steadyTickProvider(std::forward<Provider>(steadyTickProvider))
+    {}
+
+    Duration now() const
+    {
+        return m_steadyTickProvider();
+    }
+
+private:
+    SteadyTickCallbackType m_steadyTickProvider;
+};
+
+/** clock of TimerManager */
+using FunctionClockPolicy = BasicFunctionClockPolicy<std::chrono::milliseconds>;
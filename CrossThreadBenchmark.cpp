@@ -0,0 +1,75 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "TimerManager.hpp"
+
+// Contention benchmark of cross thread mode: 1..32 producer threads start and stop timers
+// owned by a TimerManager which is polled by the main thread. Producers contend only on the lock-free
+// command queue, more producers than cores show whether a preempted producer stalls the others.
+int main(void)
+{
+    constexpr int commandsPerProducer = 200000;
+    constexpr int timersPerProducer = 64;
+
+    std::printf("%10s %12s %12s %14s\n", "producers", "commands", "ns/command", "Mcommands/s");
+    for (int producers : {1, 2, 4, 8, 16, 32})
+    {
+        TimerManager manager;
+        manager.enableCrossThreadCommands();
+
+        std::vector<std::vector<std::shared_ptr<ITimer>>> timers(producers);
+        for (auto& producerTimers : timers)
+        {
+            for (int index = 0; index < timersPerProducer; ++index)
+            {
+                producerTimers.push_back(manager.createSingleShotTimer());
+            }
+        }
+
+        std::atomic<bool> go{false};
+        std::atomic<int> finished{0};
+        std::vector<std::thread> threads;
+        for (int producer = 0; producer < producers; ++producer)
+        {
+            threads.emplace_back([&, producer]() {
+                while (not go)
+                {
+                }
+                for (int command = 0; command < commandsPerProducer; ++command)
+                {
+                    auto& timer = timers[producer][(command / 2) % timersPerProducer];
+                    if (command % 2)
+                    {
+                        timer->stop();
+                    }
+                    else
+                    {
+                        timer->start(1h);
+                    }
+                }
+                ++finished;
+            });
+        }
+
+        const auto begin = std::chrono::steady_clock::now();
+        go = true;
+        while (finished < producers)
+        {
+            manager.poll();
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        manager.poll();
+        const auto elapsed = std::chrono::steady_clock::now() - begin;
+
+        const double commands = double(producers) * commandsPerProducer;
+        const double nanoseconds = std::chrono::duration<double, std::nano>(elapsed).count();
+        std::printf("%10d %12.0f %12.1f %14.2f\n", producers, commands, nanoseconds / commands, commands * 1e3 / nanoseconds);
+    }
+    return 0;
+}
@@ -1,28 +1,110 @@
 #pragma once
 #include <chrono>
+#include <cstdint>
 #include <functional>
+#include <type_traits>
+#include <utility>
 
 #include "ChronoHelpers.hpp"
+#include "InlineCallback.hpp"
 
 // allows easy to use duration literals: h, min, s, ms, (us, ns)
 // timer.start(2min)
 using namespace std::chrono_literals;
 
-class ITimer
+/** What a tick timer does when it is behind by more than one period, e.g. after a stall or a long fast forward */
+enum class MissedTickPolicy
+{
+	fireAll,    // expire once for every missed period, back to back
+	fireOnce,   // expire once, the next period counts from the poll
+	skipToPhase // expire once, the next expiry is the next one on the original period grid
+};
+
+/** Timer interface in the resolution Duration, see ITimer for milliseconds */
+template <typename Duration>
+class IBasicTimer
 {
 public:
-	virtual ~ITimer() = default;
+	using duration = Duration;
+
+	virtual ~IBasicTimer() = default;
 
 	virtual void stop() = 0;
 
-	/** Set timeout callback. Gets called when timeout happens */
+	/** Set timeout callback. Gets called when timeout happens. Also the way to pass callables too large to be stored
+	 * inline, std::function may allocate for them */
 	virtual void setTimeoutCallback(std::function<void()> callback) = 0;
 
-	virtual void start(std::chrono::milliseconds duration) = 0;
+	/** Set timeout callback without heap allocation */
+	virtual void setTimeoutCallback(InlineCallback callback) = 0;
+
+	/** Set any callable as timeout callback, stored inline: re-arming a timer with a new lambda never allocates.
+	 * Callables not fitting into InlineCallback fail to compile, pass them as std::function to store them on the
+	 * heap explicitly. */
+	template <typename Callable,
+	          typename Decayed = std::decay_t<Callable>,
+	          typename = std::enable_if_t<not std::is_same<Decayed, std::function<void()>>::value
+	                                      and not std::is_same<Decayed, InlineCallback>::value>>
+	void setTimeoutCallback(Callable&& callable)
+	{
+		static_assert(InlineCallback::fits<Decayed>(),
+		              "callable does not fit into InlineCallback, capture less or pass a std::function");
+		setTimeoutCallback(InlineCallback(std::forward<Callable>(callable)));
+	}
+
+	virtual void start(Duration duration) = 0;
+
+	/** Start with a tolerance: the timer may expire anywhere in [duration, duration + slack]. Timers with
+	 * overlapping windows are coalesced to shared deadlines, so polls wake up less often.
+	 * Tick timers keep their slack for every period. */
+	virtual void start(Duration duration, Duration slack) = 0;
+
+	/** Start to expire at expireTime on the time line of the manager, see now() of the managers, instead of relative
+	 * to the current time. An expireTime already reached expires in the next poll. Tick timers continue every period
+	 * counted from expireTime, so with fireAll and skipToPhase their deadlines never drift; they ignore a start without
+	 * period. Single shot timers ignore period, touch restarts them with the time until expireTime or, when it was
+	 * already reached, with the duration of the previous start. */
+	virtual void startAt(Duration expireTime, Duration period) = 0;
+
+	void startAt(Duration expireTime)
+	{
+		startAt(expireTime, Duration::zero());
+	}
+
+	/** Start on the grid of period shifted by phase: expires at the multiples of period plus phase on the time line of
+	 * the manager, first at the next one after the current time. Timers on the same grid share their deadlines and
+	 * expire as one batch. Tick timers stay on the grid, use skipToPhase to also keep it after stalls. */
+	virtual void startAligned(Duration period, Duration phase) = 0;
+
+	void startAligned(Duration period)
+	{
+		startAligned(period, Duration::zero());
+	}
+
+	/** Start again with a new duration, no matter if running or not. Keeps the slack of the last start.
+	 * Moving the deadline of a running timer later is O(1): the scheduler only notices when the old deadline
+	 * comes up and then moves the timer instead of expiring it. Until then timeUntilNextExpiry may report the old one. */
+	virtual void restart(Duration duration) = 0;
+
+	/** restart with the duration of the last start, e.g. to reset an idle timeout on activity */
+	virtual void touch() = 0;
 
 	virtual bool expired() const = 0;
 
 	virtual bool isRunning() const = 0;
 
-	virtual std::chrono::milliseconds getRemainingMilliseconds() const = 0;
+	virtual Duration getRemainingTime() const = 0;
+
+	/** catch-up behavior chosen on creation, fireAll for single shot timers */
+	virtual MissedTickPolicy missedTickPolicy() const = 0;
+
+	/** Periods skipped by the current expiry of a tick timer, always 0 for fireAll. Read it in the timeout callback */
+	virtual std::uint64_t missedTicks() const = 0;
+
+	std::chrono::milliseconds getRemainingMilliseconds() const
+	{
+		return std::chrono::duration_cast<std::chrono::milliseconds>(getRemainingTime());
+	}
 };
+
+using ITimer = IBasicTimer<std::chrono::milliseconds>;
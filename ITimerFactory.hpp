@@ -3,16 +3,23 @@
 #include <memory>
 
 #include "ITimer.hpp"
+#include "ITimerGroup.hpp"
 
-class ITimerFactory
+template <typename Duration>
+class IBasicTimerFactory
 {
 public:
-	virtual ~ITimerFactory() = default;
+	virtual ~IBasicTimerFactory() = default;
 
 	/** create a single shot timer. This timer stops running when timeout is reached */
-	virtual std::shared_ptr<ITimer> createSingleShotTimer() = 0;
+	virtual std::shared_ptr<IBasicTimer<Duration>> createSingleShotTimer() = 0;
 
 	/** create a cyclic timer. This continues running when timeout is reached.
-	 * It uses cycle time provided by start. */
-	virtual std::shared_ptr<ITimer> createTickTimer() = 0;
+	 * It uses cycle time provided by start. policy selects how missed periods are caught up. */
+	virtual std::shared_ptr<IBasicTimer<Duration>> createTickTimer(MissedTickPolicy policy = MissedTickPolicy::fireAll) = 0;
+
+	/** create a group for bulk operations on the timers created through it */
+	virtual std::shared_ptr<IBasicTimerGroup<Duration>> createTimerGroup() = 0;
 };
+
+using ITimerFactory = IBasicTimerFactory<std::chrono::milliseconds>;
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include "ITimer.hpp"
+
+/** Timers belonging together, e.g. those of one connection, see IBasicTimerFactory::createTimerGroup.
+ * Bulk operations cost O(timers in group). Deleting the group stops its timers, they stay usable on their own.
+ * Timers leave the group when they are deleted. */
+template <typename Duration>
+class IBasicTimerGroup
+{
+public:
+	virtual ~IBasicTimerGroup() = default;
+
+	/** create a single shot timer of the group */
+	virtual std::shared_ptr<IBasicTimer<Duration>> createSingleShotTimer() = 0;
+
+	/** create a tick timer of the group */
+	virtual std::shared_ptr<IBasicTimer<Duration>> createTickTimer(MissedTickPolicy policy = MissedTickPolicy::fireAll) = 0;
+
+	/** stop all timers of the group */
+	virtual void stopAll() = 0;
+
+	/** Freeze the group: its timers do not expire and keep their remaining time until resume. They stay running.
+	 * Timers started meanwhile count from the resume. */
+	virtual void pause() = 0;
+
+	virtual void resume() = 0;
+
+	virtual bool isPaused() const = 0;
+
+	/** number of timers of the group */
+	virtual std::size_t size() const = 0;
+};
+
+using ITimerGroup = IBasicTimerGroup<std::chrono::milliseconds>;
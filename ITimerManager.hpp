@@ -2,7 +2,8 @@
 
 #include "ITimerFactory.hpp"
 
-class ITimerManager : public ITimerFactory
+template <typename Duration>
+class IBasicTimerManager : public IBasicTimerFactory<Duration>
 {
 public:
 	/** Needs to be cyclically called in order to raise events for created timers.
@@ -12,11 +13,30 @@ public:
 
 	/** Manipulation for test: fast forward. This raises all timer events and takes care of all expired timers in that duration,
 	 * even when they are started during timeout-callbacks */
-	virtual void fastForward(std::chrono::milliseconds milliseconds) = 0;
+	virtual void fastForward(Duration duration) = 0;
 
 	/** stop timers. Only fast forward can expire timers from now on. */
 	virtual void pause() = 0;
 
 	/** restart timers. */
 	virtual void resume() = 0;
+
+	/** Returned by timeUntilNextExpiry when no timer is running */
+	static constexpr Duration noExpiry()
+	{
+		return Duration::max();
+	}
+
+	/** Time until the earliest running timer expires. Zero when a timer is already due, noExpiry() when no timer is running. */
+	virtual Duration timeUntilNextExpiry() const = 0;
+
+	/** Block until the earliest running timer expires, maxWait elapsed or wakeup() is called. Then poll.
+	 * The wait assumes the steady tick provider advances with real time. While paused only maxWait or wakeup() end it. */
+	virtual void waitAndPoll(Duration maxWait) = 0;
+
+	/** Thread-safe: end a pending waitAndPoll early, e.g. when an earlier timer was started from another thread.
+	 * When nobody waits the next waitAndPoll returns immediately. */
+	virtual void wakeup() = 0;
 };
+
+using ITimerManager = IBasicTimerManager<std::chrono::milliseconds>;
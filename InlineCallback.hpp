@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/** Move-only void() callable stored inline, it never uses the heap. Callables larger than Capacity bytes
+ * do not compile, capture less or capture a pointer to the state instead. Move-only callables are supported. */
+template <std::size_t Capacity>
+class BasicInlineCallback
+{
+public:
+    static constexpr std::size_t capacity = Capacity;
+
+    /** true when Callable can be stored */
+    template <typename Callable>
+    static constexpr bool fits()
+    {
+        return sizeof(Callable) <= Capacity and alignof(Callable) <= alignof(std::max_align_t)
+               and std::is_nothrow_move_constructible<Callable>::value;
+    }
+
+    BasicInlineCallback() = default;
+
+    BasicInlineCallback(std::nullptr_t)
+    {}
+
+    template <typename Callable,
+              typename Stored = std::decay_t<Callable>,
+              typename = std::enable_if_t<not std::is_same<Stored, BasicInlineCallback>::value>>
+    BasicInlineCallback(Callable&& callable)
+    {
+        static_assert(sizeof(Stored) <= Capacity, "callable does not fit into InlineCallback, capture less");
+        static_assert(alignof(Stored) <= alignof(std::max_align_t), "callable is over-aligned for InlineCallback");
+        static_assert(std::is_nothrow_move_constructible<Stored>::value, "callable has to be nothrow movable");
+        new (&m_storage) Stored(std::forward<Callable>(callable));
+        m_operations = &operationsFor<Stored>;
+    }
+
+    BasicInlineCallback(BasicInlineCallback&& other) noexcept
+    {
+        moveFrom(other);
+    }
+
+    BasicInlineCallback& operator=(BasicInlineCallback&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    BasicInlineCallback(const BasicInlineCallback&) = delete;
+    BasicInlineCallback& operator=(const BasicInlineCallback&) = delete;
+
+    ~BasicInlineCallback()
+    {
+        reset();
+    }
+
+    explicit operator bool() const
+    {
+        return m_operations != nullptr;
+    }
+
+    void operator()()
+    {
+        m_operations->invoke(&m_storage);
+    }
+
+    void reset()
+    {
+        if (m_operations)
+        {
+            m_operations->destroy(&m_storage);
+            m_operations = nullptr;
+        }
+    }
+
+private:
+    struct Operations
+    {
+        void (*invoke)(void* callable);
+        void (*move)(void* from, void* to);
+        void (*destroy)(void* callable);
+    };
+
+    template <typename Stored>
+    static void invoke(void* callable)
+    {
+        (*static_cast<Stored*>(callable))();
+    }
+
+    template <typename Stored>
+    static void move(void* from, void* to)
+    {
+        new (to) Stored(std::move(*static_cast<Stored*>(from)));
+        static_cast<Stored*>(from)->~Stored();
+    }
+
+    template <typename Stored>
+    static void destroy(void* callable)
+    {
+        static_cast<Stored*>(callable)->~Stored();
+    }
+
+    template <typename Stored>
+    static constexpr Operations operationsFor = {invoke<Stored>, move<Stored>, destroy<Stored>};
+
+    void moveFrom(BasicInlineCallback& other)
+    {
+        if (other.m_operations)
+        {
+            other.m_operations->move(&other.m_storage, &m_storage);
+            m_operations = other.m_operations;
+            other.m_operations = nullptr;
+        }
+    }
+
+    std::aligned_storage_t<Capacity, alignof(std::max_align_t)> m_storage;
+    const Operations* m_operations = nullptr;
+};
+
+template <std::size_t Capacity>
+constexpr std::size_t BasicInlineCallback<Capacity>::capacity;
+
+template <std::size_t Capacity>
+template <typename Stored>
+constexpr typename BasicInlineCallback<Capacity>::Operations BasicInlineCallback<Capacity>::operationsFor;
+
+/** Room for a shared pointer, a std::function or a handful of pointers and integers */
+using InlineCallback = BasicInlineCallback<48>;
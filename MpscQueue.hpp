@@ -0,0 +1,128 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+/** Unbounded multi producer single consumer queue (Dmitry Vyukov's algorithm).
+ * push() may be called from any thread, pop() only from the single consumer thread.
+ * An element pushed by a producer which is preempted in the middle of push() becomes visible to pop()
+ * only after that producer continues; elements behind it wait as well.
+ * Nodes freed by pop() are recycled through a lock-free freelist, so push() allocates only while more elements are
+ * queued than ever before. The freelist head carries a tag counting the takes, which makes a take based on a stale
+ * head fail (ABA). Nodes are deleted only with the queue, so reading a node taken by another producer is safe. */
+template <typename T>
+class MpscQueue
+{
+public:
+    MpscQueue()
+    : m_head(new Node)
+    , m_tail(m_head.load())
+    {}
+
+    ~MpscQueue()
+    {
+        T value;
+        while (pop(value))
+        {
+        }
+        delete m_tail;
+        auto node = pointerOf(m_freeNodes.load(std::memory_order_relaxed));
+        while (node)
+        {
+            auto next = node->next.load(std::memory_order_relaxed);
+            delete node;
+            node = next;
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void push(T value)
+    {
+        auto node = acquireNode();
+        node->value = std::move(value);
+        auto previous = m_head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    /** take the oldest element. Returns false when the queue is empty */
+    bool pop(T& value)
+    {
+        auto tail = m_tail;
+        auto next = tail->next.load(std::memory_order_acquire);
+        if (not next)
+        {
+            return false;
+        }
+        // next becomes the new stub node, its value is moved out
+        value = std::move(next->value);
+        next->value = T();
+        m_tail = next;
+        recycleNode(tail);
+        return true;
+    }
+
+private:
+    struct Node
+    {
+        std::atomic<Node*> next{nullptr};
+        T value;
+    };
+
+    /** freelist head: node pointer in the low bits, take counter in the bits above. 48 bit user space addresses
+     * leave 16 bits, a take fails wrongly only if the head was taken exactly 65536 times meanwhile */
+    using TaggedNode = std::uint64_t;
+    static constexpr unsigned pointerBits = sizeof(Node*) == 8 ? 48 : 32;
+    static constexpr TaggedNode pointerMask = (TaggedNode(1) << pointerBits) - 1;
+
+    static Node* pointerOf(TaggedNode tagged)
+    {
+        return reinterpret_cast<Node*>(static_cast<std::uintptr_t>(tagged & pointerMask));
+    }
+
+    static TaggedNode tagged(Node* node, TaggedNode tagOf)
+    {
+        return (tagOf & ~pointerMask) | reinterpret_cast<std::uintptr_t>(node);
+    }
+
+    /** called by producers, takes a recycled node or allocates one */
+    Node* acquireNode()
+    {
+        auto head = m_freeNodes.load(std::memory_order_acquire);
+        while (auto node = pointerOf(head))
+        {
+            // stale if another producer took the node meanwhile, then the tag check below fails
+            auto next = node->next.load(std::memory_order_relaxed);
+            if (m_freeNodes.compare_exchange_weak(head, tagged(next, head + (TaggedNode(1) << pointerBits)),
+                                                  std::memory_order_acquire, std::memory_order_acquire))
+            {
+                node->next.store(nullptr, std::memory_order_relaxed);
+                return node;
+            }
+        }
+        return new Node;
+    }
+
+    /** called by the consumer only, keeps the tag of the head */
+    void recycleNode(Node* node)
+    {
+        auto head = m_freeNodes.load(std::memory_order_relaxed);
+        do
+        {
+            node->next.store(pointerOf(head), std::memory_order_relaxed);
+        } while (not m_freeNodes.compare_exchange_weak(head, tagged(node, head), std::memory_order_release,
+                                                       std::memory_order_relaxed));
+    }
+
+    std::atomic<Node*> m_head; // last pushed node, written by producers
+    Node* m_tail;              // stub node in front of the oldest element, owned by consumer
+    std::atomic<TaggedNode> m_freeNodes{0}; // recycled nodes linked by next, see TaggedNode
+};
+
+template <typename T>
+constexpr unsigned MpscQueue<T>::pointerBits;
+
+template <typename T>
+constexpr typename MpscQueue<T>::TaggedNode MpscQueue<T>::pointerMask;
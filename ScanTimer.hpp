@@ -0,0 +1,87 @@
+#pragma once
+#include "ITimer.hpp"
+#include "TimerGroup.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+class ScanTimerManager;
+
+/** Timer of ScanTimerManager. It owns one entry of the manager's deadline arrays for its whole life. */
+class ScanTimer : public ITimer, public std::enable_shared_from_this<ScanTimer>
+{
+public:
+	ScanTimer(std::function<std::chrono::milliseconds(void)>,
+	          bool singleShot,
+	          MissedTickPolicy missedTickPolicy = MissedTickPolicy::fireAll);
+
+	~ScanTimer();
+
+	void stop() override;
+
+	using ITimer::setTimeoutCallback;
+
+	void setTimeoutCallback(std::function<void()> callback) override;
+
+	void setTimeoutCallback(InlineCallback callback) override;
+
+	void start(std::chrono::milliseconds duration) override;
+
+	void start(std::chrono::milliseconds duration, std::chrono::milliseconds slack) override;
+
+	using ITimer::startAt;
+
+	void startAt(std::chrono::milliseconds expireTime, std::chrono::milliseconds period) override;
+
+	using ITimer::startAligned;
+
+	void startAligned(std::chrono::milliseconds period, std::chrono::milliseconds phase) override;
+
+	/** writing the deadline array is O(1), so restart is eager */
+	void restart(std::chrono::milliseconds duration) override;
+
+	void touch() override;
+
+	bool expired() const override;
+
+	bool isRunning() const override;
+
+	std::chrono::milliseconds getRemainingTime() const override;
+
+	MissedTickPolicy missedTickPolicy() const override;
+
+	std::uint64_t missedTicks() const override;
+
+	using Group = BasicTimerGroup<ScanTimerManager, ScanTimer, std::chrono::milliseconds>;
+
+	friend class ScanTimerManager;
+	friend Group;
+
+private:
+	/** time of the manager, standing still while the group is paused */
+	std::chrono::milliseconds now() const;
+
+	/** Calls the timeout callback, which may replace itself meanwhile */
+	void invokeTimeoutCallback();
+
+	InlineCallback m_timeoutCallback;
+	bool m_timeoutCallbackReplaced = false; // set when the callback was replaced while it was running
+	std::function<std::chrono::milliseconds(void)> m_getTimeCallback = nullptr;
+	bool m_running = false;
+	bool m_expired = false;
+	const bool m_isSingleShot = false;
+	const MissedTickPolicy m_missedTickPolicy = MissedTickPolicy::fireAll;
+	std::uint64_t m_missedTicks = 0; // of the current expiry
+	std::chrono::milliseconds m_expireTime = 0ms;
+	std::chrono::milliseconds m_duration = 0ms;
+	std::chrono::milliseconds m_slack = 0ms;
+
+	// scheduling state, owned by the manager. m_manager is reset when the manager is deleted before the timer
+	ScanTimerManager* m_manager = nullptr;
+	std::size_t m_slot = 0;            // index into the deadline arrays of the manager
+	std::uint64_t m_startSequence = 0; // breaks ties between equal expire times, see ScanTimerManager
+	Group* m_group = nullptr;
+	ScanTimer* m_previousInGroup = nullptr;
+	ScanTimer* m_nextInGroup = nullptr;
+};
@@ -0,0 +1,474 @@
+#include "ScanTimerManager.hpp"
+#include "ScanTimer.hpp"
+
+#include <algorithm>
+#include <limits>
+#if defined(__x86_64__) or defined(__i386__)
+#include <immintrin.h>
+#define SCAN_TIMER_MANAGER_X86
+#endif
+
+namespace {
+
+constexpr std::int64_t notScheduled = std::numeric_limits<std::int64_t>::max();
+
+/** scalar scan of the entries from begin to count, the vector kernels finish with it */
+std::int64_t scanFrom(std::size_t begin,
+                      const std::int64_t* expireTimes,
+                      std::size_t count,
+                      std::int64_t now,
+                      std::vector<std::uint32_t>& due)
+{
+    auto earliest = notScheduled;
+    for (auto index = begin; index < count; ++index)
+    {
+        const auto expireTime = expireTimes[index];
+        if (expireTime <= now)
+        {
+            due.push_back(std::uint32_t(index));
+            continue;
+        }
+        earliest = std::min(earliest, expireTime);
+    }
+    return earliest;
+}
+
+std::int64_t scanScalar(const std::int64_t* expireTimes, std::size_t count, std::int64_t now, std::vector<std::uint32_t>& due)
+{
+    return scanFrom(0, expireTimes, count, now, due);
+}
+
+#ifdef SCAN_TIMER_MANAGER_X86
+/** indices of the set bits of mask, lane offset by index */
+void appendLanes(unsigned mask, std::size_t index, std::vector<std::uint32_t>& due)
+{
+    while (mask)
+    {
+        due.push_back(std::uint32_t(index + __builtin_ctz(mask)));
+        mask &= mask - 1;
+    }
+}
+
+// A lane is later when its expire time > now, movemask collects the sign bits of the compare. The earliest later
+// expire time is kept per lane, due lanes count as notScheduled. Four accumulators hide the latency of the min.
+
+__attribute__((target("avx2"))) inline void scanVectorAvx2(const std::int64_t* expireTimes,
+                                                           std::size_t index,
+                                                           __m256i nowLanes,
+                                                           __m256i& earliestLanes,
+                                                           std::vector<std::uint32_t>& due)
+{
+    const auto lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(expireTimes + index));
+    const auto later = _mm256_cmpgt_epi64(lanes, nowLanes);
+    const auto dueMask = ~unsigned(_mm256_movemask_pd(_mm256_castsi256_pd(later))) & 0xFu;
+    if (dueMask)
+    {
+        appendLanes(dueMask, index, due);
+    }
+    const auto candidates = _mm256_blendv_epi8(_mm256_set1_epi64x(notScheduled), lanes, later);
+    earliestLanes = _mm256_blendv_epi8(earliestLanes, candidates, _mm256_cmpgt_epi64(earliestLanes, candidates));
+}
+
+__attribute__((target("avx2"))) std::int64_t scanAvx2(const std::int64_t* expireTimes,
+                                                      std::size_t count,
+                                                      std::int64_t now,
+                                                      std::vector<std::uint32_t>& due)
+{
+    const auto nowLanes = _mm256_set1_epi64x(now);
+    __m256i earliestLanes[4];
+    for (auto& lanes : earliestLanes)
+    {
+        lanes = _mm256_set1_epi64x(notScheduled);
+    }
+    std::size_t index = 0;
+    for (; index + 16 <= count; index += 16)
+    {
+        scanVectorAvx2(expireTimes, index, nowLanes, earliestLanes[0], due);
+        scanVectorAvx2(expireTimes, index + 4, nowLanes, earliestLanes[1], due);
+        scanVectorAvx2(expireTimes, index + 8, nowLanes, earliestLanes[2], due);
+        scanVectorAvx2(expireTimes, index + 12, nowLanes, earliestLanes[3], due);
+    }
+    for (; index + 4 <= count; index += 4)
+    {
+        scanVectorAvx2(expireTimes, index, nowLanes, earliestLanes[0], due);
+    }
+    alignas(32) std::int64_t earliest[16];
+    for (int accumulator = 0; accumulator < 4; ++accumulator)
+    {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(earliest + 4 * accumulator), earliestLanes[accumulator]);
+    }
+    return std::min(*std::min_element(earliest, earliest + 16), scanFrom(index, expireTimes, count, now, due));
+}
+
+__attribute__((target("sse4.2"))) inline void scanVectorSse42(const std::int64_t* expireTimes,
+                                                              std::size_t index,
+                                                              __m128i nowLanes,
+                                                              __m128i& earliestLanes,
+                                                              std::vector<std::uint32_t>& due)
+{
+    const auto lanes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(expireTimes + index));
+    const auto later = _mm_cmpgt_epi64(lanes, nowLanes);
+    const auto dueMask = ~unsigned(_mm_movemask_pd(_mm_castsi128_pd(later))) & 0x3u;
+    if (dueMask)
+    {
+        appendLanes(dueMask, index, due);
+    }
+    const auto candidates = _mm_blendv_epi8(_mm_set1_epi64x(notScheduled), lanes, later);
+    earliestLanes = _mm_blendv_epi8(earliestLanes, candidates, _mm_cmpgt_epi64(earliestLanes, candidates));
+}
+
+__attribute__((target("sse4.2"))) std::int64_t scanSse42(const std::int64_t* expireTimes,
+                                                         std::size_t count,
+                                                         std::int64_t now,
+                                                         std::vector<std::uint32_t>& due)
+{
+    const auto nowLanes = _mm_set1_epi64x(now);
+    __m128i earliestLanes[4];
+    for (auto& lanes : earliestLanes)
+    {
+        lanes = _mm_set1_epi64x(notScheduled);
+    }
+    std::size_t index = 0;
+    for (; index + 8 <= count; index += 8)
+    {
+        scanVectorSse42(expireTimes, index, nowLanes, earliestLanes[0], due);
+        scanVectorSse42(expireTimes, index + 2, nowLanes, earliestLanes[1], due);
+        scanVectorSse42(expireTimes, index + 4, nowLanes, earliestLanes[2], due);
+        scanVectorSse42(expireTimes, index + 6, nowLanes, earliestLanes[3], due);
+    }
+    alignas(16) std::int64_t earliest[8];
+    for (int accumulator = 0; accumulator < 4; ++accumulator)
+    {
+        _mm_store_si128(reinterpret_cast<__m128i*>(earliest + 2 * accumulator), earliestLanes[accumulator]);
+    }
+    return std::min(*std::min_element(earliest, earliest + 8), scanFrom(index, expireTimes, count, now, due));
+}
+#endif
+
+/** min heap order of the due queue */
+template <typename DueTimer>
+bool expiresLater(const DueTimer& left, const DueTimer& right)
+{
+    return left.expireTime != right.expireTime ? left.expireTime > right.expireTime
+                                               : left.startSequence > right.startSequence;
+}
+
+} // namespace
+
+ScanTimerManager::ScanTimerManager(SteadyTickCallbackType steadyTickProvider, Kernel kernel)
+: m_timeBase(steadyTickProvider)
+, m_steadyTickCallback([this]() { return m_timeBase.now(); })
+, m_scan(scanScalar)
+, m_kernel(Kernel::scalar)
+, m_earliestBound(notScheduled)
+{
+#ifdef SCAN_TIMER_MANAGER_X86
+    if ((kernel == Kernel::automatic or kernel == Kernel::avx2) and __builtin_cpu_supports("avx2"))
+    {
+        m_scan = scanAvx2;
+        m_kernel = Kernel::avx2;
+    }
+    else if (kernel != Kernel::scalar and __builtin_cpu_supports("sse4.2"))
+    {
+        m_scan = scanSse42;
+        m_kernel = Kernel::sse42;
+    }
+#else
+    (void)kernel;
+#endif
+}
+
+ScanTimerManager::~ScanTimerManager()
+{
+    // remove local dependencies in created timers, see TimerManager
+    SteadyTickCallbackType replacementSteadyTickCallback = [clock = m_timeBase.detachedClock()]() {
+        return clock.now();
+    };
+
+    for (auto timer : m_timers)
+    {
+        timer->m_getTimeCallback = replacementSteadyTickCallback;
+        timer->m_manager = nullptr;
+    }
+    m_timers.clear();
+    m_expireTimes.clear();
+    for (auto group = m_firstGroup; group; group = group->m_nextGroup)
+    {
+        group->m_manager = nullptr;
+    }
+    m_firstGroup = nullptr;
+}
+
+std::shared_ptr<ITimer> ScanTimerManager::createSingleShotTimer()
+{
+    return createTimer(true);
+}
+
+std::shared_ptr<ITimer> ScanTimerManager::createTickTimer(MissedTickPolicy policy)
+{
+    return createTimer(false, policy);
+}
+
+std::shared_ptr<ITimerGroup> ScanTimerManager::createTimerGroup()
+{
+    return std::shared_ptr<Group>(new Group(*this), Group::Deleter());
+}
+
+std::shared_ptr<ScanTimer> ScanTimerManager::createTimer(bool singleShot, MissedTickPolicy policy)
+{
+    auto timer = std::make_shared<ScanTimer>(m_steadyTickCallback, singleShot, policy);
+    timer->m_manager = this;
+    timer->m_slot = m_timers.size();
+    m_timers.push_back(timer.get());
+    m_expireTimes.push_back(notScheduled);
+    return timer;
+}
+
+std::shared_ptr<ITimer> ScanTimerManager::createGroupTimer(bool singleShot, MissedTickPolicy policy, Group& group)
+{
+    auto timer = createTimer(singleShot, policy);
+    group.addTimer(*timer);
+    return timer;
+}
+
+void ScanTimerManager::shiftTimer(ScanTimer& timer, std::chrono::milliseconds shift)
+{
+    timer.m_expireTime += shift;
+    scheduleTimer(timer);
+}
+
+bool ScanTimerManager::postGroupOperation(Group&, TimerGroupOperation)
+{
+    return false;
+}
+
+void ScanTimerManager::registerGroup(Group& group)
+{
+    group.m_previousGroup = nullptr;
+    group.m_nextGroup = m_firstGroup;
+    if (m_firstGroup)
+    {
+        m_firstGroup->m_previousGroup = &group;
+    }
+    m_firstGroup = &group;
+}
+
+void ScanTimerManager::unregisterGroup(Group& group)
+{
+    if (group.m_previousGroup)
+    {
+        group.m_previousGroup->m_nextGroup = group.m_nextGroup;
+    }
+    else
+    {
+        m_firstGroup = group.m_nextGroup;
+    }
+    if (group.m_nextGroup)
+    {
+        group.m_nextGroup->m_previousGroup = group.m_previousGroup;
+    }
+    group.m_manager = nullptr;
+}
+
+void ScanTimerManager::scheduleTimer(ScanTimer& timer)
+{
+    // timers of paused groups are running, but not scheduled
+    if (timer.m_group and timer.m_group->isPaused())
+    {
+        return;
+    }
+    const auto expireTime = timer.m_expireTime.count();
+    timer.m_startSequence = m_startSequence++;
+    m_expireTimes[timer.m_slot] = expireTime;
+    if (expireTime < m_earliestBound)
+    {
+        // below a lower bound of all others, so the earliest one
+        m_earliestBound = expireTime;
+        m_earliestBoundExact = true;
+    }
+    // (re)started by a callback and due already, it is fired by the running poll
+    if (m_timeBase.isPolling() and expireTime <= m_currentTime)
+    {
+        pushDue(timer);
+    }
+}
+
+void ScanTimerManager::unscheduleTimer(ScanTimer& timer)
+{
+    auto& expireTime = m_expireTimes[timer.m_slot];
+    if (expireTime == m_earliestBound)
+    {
+        m_earliestBoundExact = false;
+    }
+    expireTime = notScheduled;
+}
+
+void ScanTimerManager::unregisterTimer(ScanTimer& timer)
+{
+    unscheduleTimer(timer);
+    // the last timer takes over the entries, the arrays stay dense
+    const auto slot = timer.m_slot;
+    auto last = m_timers.back();
+    m_timers[slot] = last;
+    m_expireTimes[slot] = m_expireTimes.back();
+    last->m_slot = slot;
+    m_timers.pop_back();
+    m_expireTimes.pop_back();
+    timer.m_manager = nullptr;
+    // entries of the destroyed timer go stale. The moved one needs an entry for its new slot if it is due
+    if (m_timeBase.isPolling() and slot < m_timers.size() and m_expireTimes[slot] <= m_currentTime)
+    {
+        pushDue(*last);
+    }
+}
+
+void ScanTimerManager::pushDue(ScanTimer& timer)
+{
+    m_due.push_back(DueTimer{timer.m_expireTime.count(), timer.m_startSequence, timer.m_slot});
+    std::push_heap(m_due.begin(), m_due.end(), expiresLater<DueTimer>);
+}
+
+ScanTimer* ScanTimerManager::popDue()
+{
+    while (not m_due.empty())
+    {
+        std::pop_heap(m_due.begin(), m_due.end(), expiresLater<DueTimer>);
+        const auto due = m_due.back();
+        m_due.pop_back();
+        // every start draws a new sequence number, so only the entry of the last one matches. The slot may be gone
+        // or taken over by another timer meanwhile, m_timers holds living timers only
+        if (due.slot < m_timers.size() and m_expireTimes[due.slot] == due.expireTime and
+            m_timers[due.slot]->m_startSequence == due.startSequence)
+        {
+            return m_timers[due.slot];
+        }
+    }
+    return nullptr;
+}
+
+void ScanTimerManager::fastForward(std::chrono::milliseconds milliseconds)
+{
+    // this is not allowed when polling is active
+    if (m_timeBase.isPolling())
+    {
+        return;
+    }
+    m_timeBase.fastForward(milliseconds);
+    poll();
+}
+
+void ScanTimerManager::pause()
+{
+    // this is not allowed when polling is active
+    if (m_timeBase.isPolling())
+    {
+        return;
+    }
+    m_timeBase.pause();
+}
+
+void ScanTimerManager::resume()
+{
+    // this is not allowed when polling is active
+    if (m_timeBase.isPolling())
+    {
+        return;
+    }
+    m_timeBase.resume();
+}
+
+std::chrono::milliseconds ScanTimerManager::now() const
+{
+    return m_timeBase.now();
+}
+
+std::chrono::milliseconds ScanTimerManager::timeUntilNextExpiry() const
+{
+    if (not m_due.empty())
+    {
+        return 0ms;
+    }
+    if (not m_earliestBoundExact)
+    {
+        m_scanResult.clear();
+        m_earliestBound = m_scan(m_expireTimes.data(), m_expireTimes.size(), std::numeric_limits<std::int64_t>::min(),
+                                 m_scanResult);
+        m_earliestBoundExact = true;
+    }
+    if (m_earliestBound == notScheduled)
+    {
+        return noExpiry();
+    }
+    return std::max(0ms, std::chrono::milliseconds(m_earliestBound) - m_timeBase.now());
+}
+
+void ScanTimerManager::waitAndPoll(std::chrono::milliseconds maxWait)
+{
+    // waiting inside a callback would only delay the running poll
+    if (m_timeBase.isPolling())
+    {
+        return;
+    }
+    // while paused the steady clock does not move our timers, only fast forward does
+    auto timeout = m_timeBase.isPaused() ? maxWait : std::min(maxWait, timeUntilNextExpiry());
+    m_wakeupSignal.waitFor(timeout);
+    poll();
+}
+
+void ScanTimerManager::wakeup()
+{
+    m_wakeupSignal.notify();
+}
+
+ScanTimerManager::Kernel ScanTimerManager::kernel() const
+{
+    return m_kernel;
+}
+
+void ScanTimerManager::poll()
+{
+    // only one poll at the same time allowed
+    if (m_timeBase.isPolling())
+    {
+        return;
+    }
+    const auto currentTime = m_timeBase.now();
+    m_currentTime = currentTime.count();
+    // nothing is due before the bound, the scan is skipped
+    if (m_currentTime < m_earliestBound)
+    {
+        return;
+    }
+    m_scanResult.clear();
+    m_earliestBound = m_scan(m_expireTimes.data(), m_expireTimes.size(), m_currentTime, m_scanResult);
+    m_earliestBoundExact = true;
+    m_due.clear();
+    for (auto index : m_scanResult)
+    {
+        m_due.push_back(DueTimer{m_expireTimes[index], m_timers[index]->m_startSequence, index});
+    }
+    std::make_heap(m_due.begin(), m_due.end(), expiresLater<DueTimer>);
+    // see TimerManager::poll: timers (re)started in callbacks use the expire time of the current timer as reference
+    m_timeBase.beginPoll();
+
+    while (auto due = popDue())
+    {
+        // keep timer alive during callback, even when the callback drops the last reference
+        auto timer = due->shared_from_this();
+        m_timeBase.setPollTimeStamp(timer->m_expireTime);
+        timer->stop();
+        auto restartTime = timer->m_expireTime;
+        if (not timer->m_isSingleShot)
+        {
+            restartTime = tickRestartTime(timer->m_missedTickPolicy, timer->m_expireTime, currentTime, timer->m_duration,
+                                          timer->m_missedTicks);
+        }
+        timer->invokeTimeoutCallback();
+        if (not timer->m_isSingleShot)
+        {
+            m_timeBase.setPollTimeStamp(restartTime);
+            timer->start(timer->m_duration, timer->m_slack);
+        }
+    }
+    m_timeBase.endPoll();
+}
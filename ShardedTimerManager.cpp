@@ -0,0 +1,352 @@
+#include "ShardedTimerManager.hpp"
+
+#include <algorithm>
+#include <iterator>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+constexpr std::int64_t ShardedTimerManager::notPaused;
+constexpr std::int64_t ShardedTimerManager::noDeadline;
+
+ShardedTimerManager::ShardedTimerManager(std::size_t shardCount,
+                                         SteadyTickCallbackType steadyTickProvider,
+                                         Placement placement,
+                                         bool workStealing)
+: m_clock(std::make_shared<Clock>(steadyTickProvider))
+, m_placement(placement)
+, m_workStealing(workStealing)
+{
+    shardCount = std::max<std::size_t>(shardCount, 1);
+    for (std::size_t index = 0; index < shardCount; ++index)
+    {
+        auto shard = std::make_unique<Shard>();
+        // the clock is captured by value, timers outliving us detach to it
+        shard->manager = std::make_unique<TimerManager>([clock = m_clock]() { return clock->now(); });
+        m_shards.push_back(std::move(shard));
+    }
+    // threads wait for m_started, so their managers are completely set up before the first poll
+    for (auto& shard : m_shards)
+    {
+        auto& current = *shard;
+        current.thread = std::thread([this, &current]() { run(current); });
+        current.manager->enableCrossThreadCommands(current.thread.get_id());
+        if (m_workStealing)
+        {
+            current.manager->setCallbackDispatcher([&current](const std::function<void()>& callback) {
+                std::lock_guard<std::mutex> lock(current.callbackMutex);
+                current.callbacks.push_back(callback);
+            });
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_pollMutex);
+        m_started = true;
+    }
+    m_pollCompleted.notify_all();
+}
+
+ShardedTimerManager::~ShardedTimerManager()
+{
+    m_stopping = true;
+    for (auto& shard : m_shards)
+    {
+        shard->manager->wakeup();
+    }
+    for (auto& shard : m_shards)
+    {
+        shard->thread.join();
+    }
+    // like TimerManager, detached timers see a running clock again
+    m_clock->resume();
+}
+
+std::shared_ptr<ITimer> ShardedTimerManager::createSingleShotTimer()
+{
+    return createSingleShotTimer(selectShard());
+}
+
+std::shared_ptr<ITimer> ShardedTimerManager::createTickTimer(MissedTickPolicy policy)
+{
+    return createTickTimer(selectShard(), policy);
+}
+
+std::shared_ptr<ITimer> ShardedTimerManager::createSingleShotTimer(std::size_t shardHint)
+{
+    return m_shards[shardHint % m_shards.size()]->manager->createSingleShotTimer();
+}
+
+std::shared_ptr<ITimer> ShardedTimerManager::createTickTimer(std::size_t shardHint, MissedTickPolicy policy)
+{
+    return m_shards[shardHint % m_shards.size()]->manager->createTickTimer(policy);
+}
+
+std::shared_ptr<ITimerGroup> ShardedTimerManager::createTimerGroup()
+{
+    return m_shards[selectShard() % m_shards.size()]->manager->createTimerGroup();
+}
+
+std::size_t ShardedTimerManager::shardCount() const
+{
+    return m_shards.size();
+}
+
+void ShardedTimerManager::fastForward(std::chrono::milliseconds milliseconds)
+{
+    // shard threads would wait for themselves
+    if (isShardThread())
+    {
+        return;
+    }
+    // operations posted to the shards count from before the fast forward
+    pollAllShards();
+    m_clock->offset += milliseconds.count();
+    auto pausedTime = m_clock->pausedTime.load();
+    if (pausedTime != notPaused)
+    {
+        m_clock->pausedTime = pausedTime + milliseconds.count();
+    }
+    pollAllShards();
+}
+
+void ShardedTimerManager::poll()
+{
+    if (isShardThread())
+    {
+        return;
+    }
+    pollAllShards();
+}
+
+void ShardedTimerManager::pause()
+{
+    if (isShardThread())
+    {
+        return;
+    }
+    if (m_clock->pausedTime == notPaused)
+    {
+        m_clock->pausedTime = now().count();
+    }
+}
+
+void ShardedTimerManager::resume()
+{
+    if (isShardThread())
+    {
+        return;
+    }
+    m_clock->resume();
+}
+
+std::chrono::milliseconds ShardedTimerManager::timeUntilNextExpiry() const
+{
+    auto nextExpireTime = noDeadline;
+    for (auto& shard : m_shards)
+    {
+        nextExpireTime = std::min(nextExpireTime, shard->nextExpireTime.load());
+    }
+    if (nextExpireTime == noDeadline)
+    {
+        return noExpiry();
+    }
+    return std::max(0ms, std::chrono::milliseconds(nextExpireTime) - now());
+}
+
+void ShardedTimerManager::waitAndPoll(std::chrono::milliseconds maxWait)
+{
+    if (isShardThread())
+    {
+        return;
+    }
+    auto timeout = (m_clock->pausedTime != notPaused) ? maxWait : std::min(maxWait, timeUntilNextExpiry());
+    m_wakeupSignal.waitFor(timeout);
+    pollAllShards();
+}
+
+void ShardedTimerManager::wakeup()
+{
+    m_wakeupSignal.notify();
+}
+
+std::chrono::milliseconds ShardedTimerManager::now() const
+{
+    return m_clock->now();
+}
+
+ShardedTimerManager::Clock::Clock(SteadyTickCallbackType steadyTickProvider)
+: steadyTickProvider(std::move(steadyTickProvider))
+{
+}
+
+std::chrono::milliseconds ShardedTimerManager::Clock::now() const
+{
+    auto paused = pausedTime.load();
+    if (paused != notPaused)
+    {
+        return std::chrono::milliseconds(paused);
+    }
+    return steadyTickProvider() + std::chrono::milliseconds(offset.load());
+}
+
+void ShardedTimerManager::Clock::resume()
+{
+    auto paused = pausedTime.load();
+    if (paused != notPaused)
+    {
+        // continue at the time we paused
+        offset = paused - steadyTickProvider().count();
+        pausedTime = notPaused;
+    }
+}
+
+std::size_t ShardedTimerManager::selectShard()
+{
+#ifdef __linux__
+    if (m_placement == Placement::callerCpu)
+    {
+        auto cpu = sched_getcpu();
+        if (cpu >= 0)
+        {
+            return static_cast<std::size_t>(cpu);
+        }
+    }
+#endif
+    return m_nextShard++;
+}
+
+bool ShardedTimerManager::isShardThread() const
+{
+    const auto currentThread = std::this_thread::get_id();
+    for (auto& shard : m_shards)
+    {
+        if (shard->thread.get_id() == currentThread)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ShardedTimerManager::run(Shard& shard)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_pollMutex);
+        m_pollCompleted.wait(lock, [this]() { return m_started; });
+    }
+    while (not m_stopping)
+    {
+        std::uint64_t requestedPolls;
+        {
+            std::lock_guard<std::mutex> lock(m_pollMutex);
+            requestedPolls = shard.requestedPolls;
+        }
+        // a poll requested while we were busy has to start after the request, so do not wait then
+        const bool pollRequested = requestedPolls != shard.completedPolls;
+        shard.manager->waitAndPoll(pollRequested ? 0ms : noExpiry());
+
+        const auto timeUntilNextExpiry = shard.manager->timeUntilNextExpiry();
+        shard.nextExpireTime = (timeUntilNextExpiry == noExpiry()) ? noDeadline : (now() + timeUntilNextExpiry).count();
+
+        if (m_workStealing)
+        {
+            runCallbacks(shard);
+            while (stealCallbacks(shard))
+            {
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_pollMutex);
+            shard.completedPolls = requestedPolls;
+        }
+        m_pollCompleted.notify_all();
+    }
+}
+
+void ShardedTimerManager::runCallbacks(Shard& shard)
+{
+    bool backlogAnnounced = false;
+    while (true)
+    {
+        std::function<void()> callback;
+        {
+            std::lock_guard<std::mutex> lock(shard.callbackMutex);
+            if (shard.callbacks.empty())
+            {
+                return;
+            }
+            callback = std::move(shard.callbacks.front());
+            shard.callbacks.pop_front();
+            // more callbacks wait behind this one, idle shards may take them over
+            if (not shard.callbacks.empty() and not backlogAnnounced)
+            {
+                backlogAnnounced = true;
+                for (auto& other : m_shards)
+                {
+                    if (other.get() != &shard)
+                    {
+                        other->manager->wakeup();
+                    }
+                }
+            }
+        }
+        callback();
+    }
+}
+
+bool ShardedTimerManager::stealCallbacks(Shard& thief)
+{
+    for (auto& victim : m_shards)
+    {
+        if (victim.get() == &thief)
+        {
+            continue;
+        }
+        std::deque<std::function<void()>> batch;
+        {
+            std::lock_guard<std::mutex> lock(victim->callbackMutex);
+            // the victim keeps the older half, it works from the front
+            const auto stolen = (victim->callbacks.size() + 1) / 2;
+            auto first = victim->callbacks.end() - stolen;
+            std::move(first, victim->callbacks.end(), std::back_inserter(batch));
+            victim->callbacks.erase(first, victim->callbacks.end());
+        }
+        if (batch.empty())
+        {
+            continue;
+        }
+        for (auto& callback : batch)
+        {
+            callback();
+        }
+        return true;
+    }
+    return false;
+}
+
+void ShardedTimerManager::pollAllShards()
+{
+    std::vector<std::uint64_t> requestedPolls;
+    {
+        std::lock_guard<std::mutex> lock(m_pollMutex);
+        for (auto& shard : m_shards)
+        {
+            requestedPolls.push_back(++shard->requestedPolls);
+        }
+    }
+    for (auto& shard : m_shards)
+    {
+        shard->manager->wakeup();
+    }
+    std::unique_lock<std::mutex> lock(m_pollMutex);
+    m_pollCompleted.wait(lock, [&]() {
+        for (std::size_t index = 0; index < m_shards.size(); ++index)
+        {
+            if (m_shards[index]->completedPolls < requestedPolls[index])
+            {
+                return false;
+            }
+        }
+        return true;
+    });
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "ITimerManager.hpp"
+#include "TimerManager.hpp"
+#include "WakeupSignal.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** Timer manager distributing its timers over N TimerManager shards, each polled by its own thread.
+ * Timeout callbacks run on the thread of the shard owning the timer. Timers can be used from any thread,
+ * see TimerManager::enableCrossThreadCommands: operations from other threads are executed by the next poll
+ * of the owning shard. Expiry order is kept within a shard, timers of different shards expire concurrently.
+ *
+ * All shards share one time base, so fastForward, pause and resume apply to all shards at once.
+ * poll() and fastForward() return after every shard completed a poll which started after the call.
+ * fastForward() lets the shards process pending timer operations before it moves the time.
+ * Manager operations called from a timeout callback are ignored, like those of TimerManager during poll.
+ *
+ * With work stealing shards do not call callbacks inside their poll but queue them. A shard thread without
+ * queued callbacks takes over the younger half of the callbacks queued by another shard. Stolen callbacks
+ * run out of order and do not wait for fastForward/poll. */
+class ShardedTimerManager : public ITimerManager
+{
+public:
+    using SteadyTickCallbackType = TimerManager::SteadyTickCallbackType;
+
+    enum class Placement
+    {
+        roundRobin, // shards are used in turn
+        callerCpu   // shard of the CPU the creating thread runs on
+    };
+
+    ShardedTimerManager(std::size_t shardCount = std::thread::hardware_concurrency(),
+                        SteadyTickCallbackType steadyTickProvider = getChronoSteadyClockTicks,
+                        Placement placement = Placement::roundRobin,
+                        bool workStealing = false);
+
+    ~ShardedTimerManager();
+
+    std::shared_ptr<ITimer> createSingleShotTimer() override;
+
+    std::shared_ptr<ITimer> createTickTimer(MissedTickPolicy policy = MissedTickPolicy::fireAll) override;
+
+    /** create a timer owned by shard shardHint modulo shard count */
+    std::shared_ptr<ITimer> createSingleShotTimer(std::size_t shardHint);
+
+    std::shared_ptr<ITimer> createTickTimer(std::size_t shardHint, MissedTickPolicy policy = MissedTickPolicy::fireAll);
+
+    /** all timers of a group belong to one shard, chosen like the shard of a timer */
+    std::shared_ptr<ITimerGroup> createTimerGroup() override;
+
+    std::size_t shardCount() const;
+
+    void fastForward(std::chrono::milliseconds milliseconds) override;
+
+    void poll() override;
+
+    void pause() override;
+
+    void resume() override;
+
+    /** earliest expiry of all shards as of their last poll */
+    std::chrono::milliseconds timeUntilNextExpiry() const override;
+
+    void waitAndPoll(std::chrono::milliseconds maxWait) override;
+
+    void wakeup() override;
+
+private:
+    static constexpr std::int64_t notPaused = INT64_MIN;
+    static constexpr std::int64_t noDeadline = INT64_MAX;
+
+    struct Shard
+    {
+        std::unique_ptr<TimerManager> manager;
+        std::thread thread;
+        std::uint64_t requestedPolls = 0; // protected by m_pollMutex
+        std::uint64_t completedPolls = 0;
+        std::atomic<std::int64_t> nextExpireTime{noDeadline};
+        std::mutex callbackMutex;
+        std::deque<std::function<void()>> callbacks; // queued callbacks in work stealing mode
+    };
+
+    /** time base of all shards: steady ticks plus offsets, frozen while paused. The clocks of the shards share it,
+     * so timers outliving the manager keep a valid time */
+    struct Clock
+    {
+        explicit Clock(SteadyTickCallbackType steadyTickProvider);
+
+        std::chrono::milliseconds now() const;
+
+        /** continue at the paused time */
+        void resume();
+
+        SteadyTickCallbackType steadyTickProvider;
+        std::atomic<std::int64_t> offset{0};
+        std::atomic<std::int64_t> pausedTime{notPaused};
+    };
+
+    ShardedTimerManager(const ShardedTimerManager&) = delete;
+    ShardedTimerManager(ShardedTimerManager&&) = delete;
+
+    std::chrono::milliseconds now() const;
+
+    std::size_t selectShard();
+    bool isShardThread() const;
+    void run(Shard& shard);
+    void runCallbacks(Shard& shard);
+    bool stealCallbacks(Shard& thief);
+    void pollAllShards();
+
+    const std::shared_ptr<Clock> m_clock;
+    const Placement m_placement;
+    const bool m_workStealing;
+    std::vector<std::unique_ptr<Shard>> m_shards;
+    std::atomic<std::size_t> m_nextShard{0};
+    std::atomic<bool> m_stopping{false};
+    std::mutex m_pollMutex;
+    std::condition_variable m_pollCompleted;
+    bool m_started = false; // protected by m_pollMutex, shard threads wait for it
+    WakeupSignal m_wakeupSignal;
+};
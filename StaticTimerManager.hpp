@@ -0,0 +1,287 @@
+#pragma once
+
+#include "ClockPolicy.hpp"
+#include "ITimer.hpp"
+#include "InlineCallback.hpp"
+#include "TimeBase.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/** Timer manager for a timer set known at build time, e.g. on embedded targets. Storage for Capacity timers is part
+ * of the manager, callbacks are stored inline and timers are handed out as non-owning references: it never allocates.
+ * Timers live as long as the manager.
+ *
+ * start, stop, poll, fastForward and pause behave like BasicTimerManager: callbacks see the expire time of their timer
+ * as current time, timers expire in deadline order and equal deadlines in creation order. The deadlines are a
+ * contiguous array, stopped timers hold noExpiry(). Poll scans it for the earliest one, O(Capacity) per expiry
+ * without indirection, which beats a heap for a few dozen timers. Single threaded. */
+template <std::size_t Capacity,
+          typename ClockPolicy = SteadyClockPolicy,
+          typename Duration = std::chrono::milliseconds,
+          std::size_t CallbackCapacity = InlineCallback::capacity>
+class StaticTimerManager
+{
+public:
+    using Callback = BasicInlineCallback<CallbackCapacity>;
+
+    /** Non-owning reference to a timer of the manager, cheap to copy. An empty one refers to no timer and must not
+     * be used, createSingleShotTimer and createTickTimer return it when all timers are taken. */
+    class Timer
+    {
+    public:
+        Timer() = default;
+
+        explicit operator bool() const
+        {
+            return m_manager != nullptr;
+        }
+
+        void setTimeoutCallback(Callback callback)
+        {
+            m_manager->setTimeoutCallback(m_index, std::move(callback));
+        }
+
+        /** see ITimer::start, starting a running timer is ignored */
+        void start(Duration duration, Duration slack = Duration::zero())
+        {
+            m_manager->start(m_index, duration, slack);
+        }
+
+        void restart(Duration duration)
+        {
+            m_manager->restart(m_index, duration);
+        }
+
+        void stop()
+        {
+            m_manager->stop(m_index);
+        }
+
+        bool isRunning() const
+        {
+            return m_manager->m_deadlines[m_index] != noExpiry();
+        }
+
+        Duration getRemainingTime() const
+        {
+            return m_manager->remaining(m_index);
+        }
+
+        /** see ITimer::missedTicks */
+        std::uint64_t missedTicks() const
+        {
+            return m_manager->m_timers[m_index].missedTicks;
+        }
+
+    private:
+        friend StaticTimerManager;
+
+        Timer(StaticTimerManager& manager, std::size_t index)
+        : m_manager(&manager)
+        , m_index(index)
+        {}
+
+        StaticTimerManager* m_manager = nullptr;
+        std::size_t m_index = 0;
+    };
+
+    explicit StaticTimerManager(ClockPolicy clock = ClockPolicy())
+    : m_timeBase(std::move(clock))
+    {
+        m_deadlines.fill(noExpiry());
+    }
+
+    StaticTimerManager(const StaticTimerManager&) = delete;
+    StaticTimerManager& operator=(const StaticTimerManager&) = delete;
+
+    Timer createSingleShotTimer()
+    {
+        return createTimer(true, MissedTickPolicy::fireAll);
+    }
+
+    Timer createTickTimer(MissedTickPolicy policy = MissedTickPolicy::fireAll)
+    {
+        return createTimer(false, policy);
+    }
+
+    /** see IBasicTimerManager::poll */
+    void poll();
+
+    /** see IBasicTimerManager::fastForward */
+    void fastForward(Duration duration)
+    {
+        // this is not allowed when polling is active
+        if (m_timeBase.isPolling())
+        {
+            return;
+        }
+        m_timeBase.fastForward(duration);
+        poll();
+    }
+
+    void pause()
+    {
+        if (not m_timeBase.isPolling())
+        {
+            m_timeBase.pause();
+        }
+    }
+
+    void resume()
+    {
+        if (not m_timeBase.isPolling())
+        {
+            m_timeBase.resume();
+        }
+    }
+
+    static constexpr Duration noExpiry()
+    {
+        return Duration::max();
+    }
+
+    /** see IBasicTimerManager::timeUntilNextExpiry */
+    Duration timeUntilNextExpiry() const
+    {
+        const auto index = earliest();
+        if (index == Capacity)
+        {
+            return noExpiry();
+        }
+        const auto remaining = m_deadlines[index] - m_timeBase.now();
+        return remaining > Duration::zero() ? remaining : Duration::zero();
+    }
+
+    /** number of created timers */
+    std::size_t size() const
+    {
+        return m_size;
+    }
+
+    static constexpr std::size_t capacity()
+    {
+        return Capacity;
+    }
+
+private:
+    struct TimerState
+    {
+        Callback callback;
+        Duration duration = Duration::zero();
+        Duration slack = Duration::zero();
+        std::uint64_t missedTicks = 0; // of the current expiry
+        MissedTickPolicy missedTickPolicy = MissedTickPolicy::fireAll;
+        bool singleShot = true;
+        bool callbackReplaced = false; // set when the callback was replaced while it was running
+    };
+
+    Timer createTimer(bool singleShot, MissedTickPolicy policy)
+    {
+        if (m_size == Capacity)
+        {
+            return Timer();
+        }
+        auto& timer = m_timers[m_size];
+        timer.singleShot = singleShot;
+        timer.missedTickPolicy = policy;
+        return Timer(*this, m_size++);
+    }
+
+    void setTimeoutCallback(std::size_t index, Callback callback)
+    {
+        m_timers[index].callback = std::move(callback);
+        m_timers[index].callbackReplaced = true;
+    }
+
+    void start(std::size_t index, Duration duration, Duration slack)
+    {
+        if (m_deadlines[index] != noExpiry() or duration == Duration::zero())
+        {
+            return;
+        }
+        m_timers[index].duration = duration;
+        m_timers[index].slack = slack;
+        m_deadlines[index] = coalesceDeadline(m_timeBase.now() + duration, slack);
+    }
+
+    void restart(std::size_t index, Duration duration)
+    {
+        stop(index);
+        start(index, duration, m_timers[index].slack);
+    }
+
+    void stop(std::size_t index)
+    {
+        m_deadlines[index] = noExpiry();
+    }
+
+    Duration remaining(std::size_t index) const
+    {
+        return m_deadlines[index] == noExpiry() ? Duration::zero() : m_deadlines[index] - m_timeBase.now();
+    }
+
+    /** index of the earliest deadline, the lowest index of equal ones. Capacity when no timer is running */
+    std::size_t earliest() const
+    {
+        auto index = Capacity;
+        auto deadline = noExpiry();
+        for (std::size_t candidate = 0; candidate < m_size; ++candidate)
+        {
+            const auto candidateDeadline = m_deadlines[candidate];
+            const auto earlier = candidateDeadline < deadline;
+            index = earlier ? candidate : index;
+            deadline = earlier ? candidateDeadline : deadline;
+        }
+        return index;
+    }
+
+    BasicTimeBase<ClockPolicy, Duration> m_timeBase;
+    std::array<Duration, Capacity> m_deadlines; // per timer, noExpiry() while stopped
+    std::array<TimerState, Capacity> m_timers;
+    std::size_t m_size = 0;
+};
+
+template <std::size_t Capacity, typename ClockPolicy, typename Duration, std::size_t CallbackCapacity>
+void StaticTimerManager<Capacity, ClockPolicy, Duration, CallbackCapacity>::poll()
+{
+    // only one poll at the same time allowed
+    if (m_timeBase.isPolling())
+    {
+        return;
+    }
+    const auto currentTime = m_timeBase.now();
+    // timers (re)started in callbacks count from the expire time of the current timer, see BasicTimerManager::poll
+    m_timeBase.beginPoll();
+    for (auto index = earliest(); index != Capacity and m_deadlines[index] <= currentTime; index = earliest())
+    {
+        auto& timer = m_timers[index];
+        const auto expireTime = m_deadlines[index];
+        m_timeBase.setPollTimeStamp(expireTime);
+        m_deadlines[index] = noExpiry();
+        auto restartTime = expireTime;
+        if (not timer.singleShot)
+        {
+            restartTime = tickRestartTime(timer.missedTickPolicy, expireTime, currentTime, timer.duration, timer.missedTicks);
+        }
+        // the callback leaves its slot while it runs, a callback replacing itself must not destroy the running one
+        auto callback = std::move(timer.callback);
+        timer.callbackReplaced = false;
+        if (callback)
+        {
+            callback();
+        }
+        if (not timer.callbackReplaced)
+        {
+            timer.callback = std::move(callback);
+        }
+        if (not timer.singleShot)
+        {
+            m_timeBase.setPollTimeStamp(restartTime);
+            start(index, timer.duration, timer.slack);
+        }
+    }
+    m_timeBase.endPoll();
+}
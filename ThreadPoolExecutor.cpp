@@ -0,0 +1,84 @@
+#include "ThreadPoolExecutor.hpp"
+
+#include <algorithm>
+
+ThreadPoolExecutor::ThreadPoolExecutor(std::size_t threadCount)
+{
+    threadCount = std::max<std::size_t>(threadCount, 1);
+    for (std::size_t index = 0; index < threadCount; ++index)
+    {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    for (auto& worker : m_workers)
+    {
+        auto current = worker.get();
+        worker->thread = std::thread([this, current]() { run(*current); });
+    }
+}
+
+ThreadPoolExecutor::~ThreadPoolExecutor()
+{
+    for (auto& worker : m_workers)
+    {
+        {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+            worker->stopping = true;
+        }
+        worker->condition.notify_one();
+    }
+    for (auto& worker : m_workers)
+    {
+        worker->thread.join();
+    }
+}
+
+void ThreadPoolExecutor::execute(std::uint64_t key, std::function<void()> task)
+{
+    // timer keys are sequence numbers, the hash spreads any other pattern of group keys as well
+    auto& worker = *m_workers[(key * 0x9E3779B97F4A7C15ull >> 32) % m_workers.size()];
+    m_pendingTasks.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back(std::move(task));
+    }
+    worker.condition.notify_one();
+}
+
+void ThreadPoolExecutor::waitIdle()
+{
+    // a task queueing another one counts it before it is done itself, so the count is not zero in between
+    std::unique_lock<std::mutex> lock(m_idleMutex);
+    m_idleCondition.wait(lock, [this]() { return m_pendingTasks.load(std::memory_order_acquire) == 0; });
+}
+
+std::size_t ThreadPoolExecutor::threadCount() const
+{
+    return m_workers.size();
+}
+
+void ThreadPoolExecutor::run(Worker& worker)
+{
+    std::unique_lock<std::mutex> lock(worker.mutex);
+    while (true)
+    {
+        worker.condition.wait(lock, [&worker]() { return worker.stopping or not worker.tasks.empty(); });
+        if (worker.tasks.empty())
+        {
+            return;
+        }
+        auto task = std::move(worker.tasks.front());
+        worker.tasks.pop_front();
+        lock.unlock();
+        task();
+        task = nullptr;
+        if (m_pendingTasks.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            // waitIdle checks under this mutex, taking it orders the notification after a check
+            {
+                std::lock_guard<std::mutex> idleLock(m_idleMutex);
+            }
+            m_idleCondition.notify_all();
+        }
+        lock.lock();
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** Fixed pool of worker threads running timeout callbacks, see BasicTimerManager::setCallbackExecutor.
+ * Every key is bound to one worker: tasks with equal key run one after the other in submission order, tasks with
+ * different keys spread over the workers. A long task delays the other keys of its worker, no stealing, as that
+ * would break the order. */
+class ThreadPoolExecutor
+{
+public:
+    explicit ThreadPoolExecutor(std::size_t threadCount = std::thread::hardware_concurrency());
+
+    /** runs the queued tasks, then joins the workers */
+    ~ThreadPoolExecutor();
+
+    /** thread-safe */
+    void execute(std::uint64_t key, std::function<void()> task);
+
+    /** Block until every task executed before the call has run, e.g. after fastForward in tests.
+     * Tasks queueing further tasks are waited for as well. */
+    void waitIdle();
+
+    std::size_t threadCount() const;
+
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::deque<std::function<void()>> tasks;
+        bool stopping = false;
+        std::thread thread;
+    };
+
+    ThreadPoolExecutor(const ThreadPoolExecutor&) = delete;
+    ThreadPoolExecutor& operator=(const ThreadPoolExecutor&) = delete;
+
+    void run(Worker& worker);
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::atomic<std::size_t> m_pendingTasks{0}; // executed and not yet done
+    std::mutex m_idleMutex;
+    std::condition_variable m_idleCondition;
+};
@@ -0,0 +1,237 @@
+#pragma once
+
+#include "ClockPolicy.hpp"
+#include "ITimer.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+/** Time source shared by a timer manager and its timers. Applies fast forward and pause offsets to the
+ * clock policy and freezes time at the expire time of the currently processed timer while polling.
+ * Fast forward and pause are folded into a single offset, so reading the time is one clock read plus an add.
+ * A rescaled time base runs at a multiple of the clock, counted from the clock time of the rescale. */
+template <typename ClockPolicy, typename Duration = std::chrono::milliseconds>
+class BasicTimeBase
+{
+public:
+    using SteadyTickCallbackType = std::function<Duration(void)>;
+
+    /** clock for timers which outlive their manager: the clock policy plus the offset and rate at detach time */
+    class DetachedClock
+    {
+    public:
+        DetachedClock(const ClockPolicy& clock, Duration offset, Duration scaleOrigin = Duration::zero(), double rate = 1.0)
+        : m_clock(clock)
+        , m_offset(offset)
+        , m_scaleOrigin(scaleOrigin)
+        , m_rate(rate)
+        {}
+
+        Duration now() const
+        {
+            return scale(std::chrono::duration_cast<Duration>(m_clock.now()), m_scaleOrigin, m_rate) + m_offset;
+        }
+
+    private:
+        ClockPolicy m_clock;
+        Duration m_offset;
+        Duration m_scaleOrigin;
+        double m_rate;
+    };
+
+    explicit BasicTimeBase(ClockPolicy clock)
+    : m_clock(std::move(clock))
+    {}
+
+    /** current time as seen by timers */
+    Duration now() const
+    {
+        // in polling we want to restart timers and this is assume to be happen at expiring time-stamp
+        // this ensures time correct behavior (maybe too late compared to provided clock, but we do not forget any expired timer)
+        if (m_isCurrentlyPolling)
+        {
+            return m_pollTimeStamp;
+        }
+        // In paused mode we do not provide a steady clock
+        return scaled(m_paused ? m_pausingTime : clockNow()) + m_offset;
+    }
+
+    DetachedClock detachedClock() const
+    {
+        return DetachedClock(m_clock, now() - scaled(clockNow()), m_scaleOrigin, m_rate);
+    }
+
+    /** while polling now() returns the poll time stamp, which is the expire time of the currently processed timer */
+    void beginPoll()
+    {
+        m_isCurrentlyPolling = true;
+    }
+
+    void setPollTimeStamp(Duration pollTimeStamp)
+    {
+        m_pollTimeStamp = pollTimeStamp;
+    }
+
+    void endPoll()
+    {
+        m_isCurrentlyPolling = false;
+    }
+
+    bool isPolling() const
+    {
+        return m_isCurrentlyPolling;
+    }
+
+    void fastForward(Duration duration)
+    {
+        m_offset += duration;
+    }
+
+    void pause()
+    {
+        if (not m_paused)
+        {
+            m_pausingTime = clockNow();
+            m_paused = true;
+        }
+    }
+
+    void resume()
+    {
+        if (m_paused)
+        {
+            m_paused = false;
+            // the paused period is taken out of the time line
+            m_offset += scaled(m_pausingTime) - scaled(clockNow());
+        }
+    }
+
+    bool isPaused() const
+    {
+        return m_paused;
+    }
+
+    /** From now on time runs at rate times the clock, 2.0 runs twice as fast. The time continues where it is.
+     * Ignores rates which are not positive, pause stops the time */
+    void rescale(double rate)
+    {
+        if (not(rate > 0.0))
+        {
+            return;
+        }
+        // the time up to the rescale goes into the offset, the new rate counts from the current clock time
+        const auto clockTime = m_paused ? m_pausingTime : clockNow();
+        m_offset += scaled(clockTime) - clockTime;
+        m_scaleOrigin = clockTime;
+        m_rate = rate;
+    }
+
+    double rate() const
+    {
+        return m_rate;
+    }
+
+    /** clock time passing while duration passes in our time, rounded up so waits do not end early */
+    Duration toClockDuration(Duration duration) const
+    {
+        if (m_rate == 1.0 or duration == Duration::max())
+        {
+            return duration;
+        }
+        auto clockDuration = std::chrono::duration_cast<Duration>(duration / m_rate);
+        return clockDuration * m_rate < duration ? clockDuration + Duration(1) : clockDuration;
+    }
+
+private:
+    /** the clock in our resolution, finer clocks are truncated */
+    Duration clockNow() const
+    {
+        return std::chrono::duration_cast<Duration>(m_clock.now());
+    }
+
+    static Duration scale(Duration clockTime, Duration scaleOrigin, double rate)
+    {
+        return rate == 1.0 ? clockTime
+                           : scaleOrigin + std::chrono::duration_cast<Duration>((clockTime - scaleOrigin) * rate);
+    }
+
+    Duration scaled(Duration clockTime) const
+    {
+        return scale(clockTime, m_scaleOrigin, m_rate);
+    }
+
+    ClockPolicy m_clock;
+    Duration m_offset = Duration::zero(); // fast forward, paused periods and time before the last rescale
+    Duration m_scaleOrigin = Duration::zero(); // clock time of the last rescale
+    double m_rate = 1.0;
+    Duration m_pollTimeStamp = Duration::zero();
+    Duration m_pausingTime = Duration::zero();
+    bool m_paused = false;
+    bool m_isCurrentlyPolling = false;
+};
+
+using TimeBase = BasicTimeBase<FunctionClockPolicy>;
+
+/** First point at or after deadline on the grid of the largest power of two not above slack, so it lies inside
+ * [deadline, deadline + slack]. Deadlines with overlapping windows mostly end up on the same grid point, see ITimer::start */
+template <typename Duration>
+Duration coalesceDeadline(Duration deadline, Duration slack)
+{
+    using Rep = typename Duration::rep;
+    if (slack <= Duration::zero())
+    {
+        return deadline;
+    }
+    Rep grid = 1;
+    while (grid <= slack.count() / 2)
+    {
+        grid *= 2;
+    }
+    auto remainder = deadline.count() % grid;
+    if (remainder < 0)
+    {
+        remainder += grid;
+    }
+    return remainder == 0 ? deadline : deadline + Duration(grid - remainder);
+}
+
+/** First point after time on the grid of period shifted by phase, see ITimer::startAligned */
+template <typename Duration>
+Duration nextAlignedTime(Duration time, Duration period, Duration phase)
+{
+    auto offset = (time - phase) % period;
+    if (offset < Duration::zero())
+    {
+        offset += period;
+    }
+    return time - offset + period;
+}
+
+/** Duration touch and restart use after ITimer::startAt of a single shot timer: the time until its expire time, for
+ * one already reached the duration of the previous start, at least one tick. Never zero, which start would ignore */
+template <typename Duration>
+Duration startAtDuration(Duration untilExpiry, Duration previous)
+{
+    if (untilExpiry > Duration::zero())
+    {
+        return untilExpiry;
+    }
+    return previous > Duration::zero() ? previous : Duration(1);
+}
+
+/** Time from which the next period of a tick timer counts when it expires at expireTime in a poll at pollTime.
+ * Stores the periods skipped by policy in missedTicks, see MissedTickPolicy */
+template <typename Duration>
+Duration tickRestartTime(MissedTickPolicy policy, Duration expireTime, Duration pollTime, Duration period,
+                         std::uint64_t& missedTicks)
+{
+    missedTicks = 0;
+    if (policy == MissedTickPolicy::fireAll or period <= Duration::zero() or pollTime - expireTime < period)
+    {
+        return expireTime;
+    }
+    const auto missed = (pollTime - expireTime) / period;
+    missedTicks = static_cast<std::uint64_t>(missed);
+    return policy == MissedTickPolicy::fireOnce ? pollTime : expireTime + missed * period;
+}
@@ -1,31 +1,378 @@
 #pragma once
+#include "ClockPolicy.hpp"
 #include "ITimer.hpp"
+#include "TimeBase.hpp"
+#include "TimerGroup.hpp"
+#include "TimerHeap.hpp"
+#include "TimerId.hpp"
 
-class Timer : public ITimer
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+template <typename ClockPolicy, typename Duration>
+class BasicTimerManager;
+
+/** Dispatch class of a timer of BasicTimerManager: due timers of a higher class expire first in a poll, see
+ * BasicTimerManager::setStarvationLimit */
+enum class TimerPriority
+{
+	high,
+	normal,
+	low
+};
+
+constexpr std::size_t timerPriorityCount = 3;
+
+template <typename ClockPolicy, typename Duration = std::chrono::milliseconds>
+class BasicTimer : public IBasicTimer<Duration>, public std::enable_shared_from_this<BasicTimer<ClockPolicy, Duration>>
 {
 public:
-	Timer(std::function<std::chrono::milliseconds(void)>, bool singleShot);
+	using Manager = BasicTimerManager<ClockPolicy, Duration>;
+	using DetachedClock = typename BasicTimeBase<ClockPolicy, Duration>::DetachedClock;
+	using Group = BasicTimerGroup<Manager, BasicTimer, Duration>;
+
+	BasicTimer(Manager& manager, bool singleShot, MissedTickPolicy missedTickPolicy = MissedTickPolicy::fireAll);
+
+	~BasicTimer();
 
 	void stop() override;
 
+	using IBasicTimer<Duration>::setTimeoutCallback;
+
 	void setTimeoutCallback(std::function<void()> callback) override;
 
-	void start(std::chrono::milliseconds duration) override;
+	void setTimeoutCallback(InlineCallback callback) override;
+
+	void start(Duration duration) override;
+
+	void start(Duration duration, Duration slack) override;
+
+	using IBasicTimer<Duration>::startAt;
+
+	void startAt(Duration expireTime, Duration period) override;
+
+	using IBasicTimer<Duration>::startAligned;
+
+	void startAligned(Duration period, Duration phase) override;
+
+	void restart(Duration duration) override;
+
+	void touch() override;
 
 	bool expired() const override;
 
 	bool isRunning() const override;
 
-	std::chrono::milliseconds getRemainingMilliseconds() const override;
+	Duration getRemainingTime() const override;
+
+	MissedTickPolicy missedTickPolicy() const override;
 
-	friend class TimerManager;
+	std::uint64_t missedTicks() const override;
+
+	friend Manager;
+	friend Group;
+	friend class BasicTimerHeap<BasicTimer>;
 
 private:
-	std::function<void()> m_timeoutCallback = nullptr;
-	std::function<std::chrono::milliseconds(void)> m_getTimeCallback = nullptr;
+	/** time of the manager, standing still while the group is paused, or of the detached clock when the manager was
+	 * deleted before the timer */
+	Duration now() const;
+
+	/** Calls the timeout callback, which may replace itself meanwhile. Calls from dispatched callbacks are
+	 * serialized per timer and safe against callbacks set by the owner thread. */
+	void invokeTimeoutCallback();
+
+	void lockTimeoutCallback();
+	void unlockTimeoutCallback();
+
+	InlineCallback m_timeoutCallback;
+	bool m_timeoutCallbackReplaced = false;  // set when the callback was replaced while it was running
+	std::atomic<bool> m_callbackLock{false}; // guards m_timeoutCallback against dispatched callbacks
+	std::atomic<bool> m_callbackRunning{false};
+	std::shared_ptr<const DetachedClock> m_detachedClock; // shared by all timers of a manager
 	bool m_running = false;
 	bool m_expired = false;
 	const bool m_isSingleShot = false;
-	std::chrono::milliseconds m_expireTime = 0ms;
-	std::chrono::milliseconds m_duration = 0ms;
+	bool m_embedded = false; // lives inside another object, see BasicTimerManager::EmbeddedTimer
+	TimerId m_handle;        // set for timers of the handle table, see BasicTimerManager::createSingleShotTimerId
+	const MissedTickPolicy m_missedTickPolicy = MissedTickPolicy::fireAll;
+	std::uint64_t m_missedTicks = 0; // of the current expiry
+	Duration m_expireTime = Duration::zero(); // position in the deadline index, may be earlier than m_deadline
+	Duration m_deadline = Duration::zero();   // expire time set by the last (re)start
+	Duration m_duration = Duration::zero();
+	Duration m_slack = Duration::zero();
+
+	// scheduling state, owned by the manager. m_manager is reset when the manager is deleted before the timer
+	Manager* m_manager = nullptr;
+	BasicTimer* m_previousTimer = nullptr; // intrusive list of all timers of the manager
+	BasicTimer* m_nextTimer = nullptr;
+	std::size_t m_heapIndex = BasicTimerHeap<BasicTimer>::npos;
+	std::uint64_t m_sequence = 0; // creation order, breaks ties between equal expire times
+	std::uint64_t m_orderingKey = 0; // callbacks with equal key keep their order with a callback executor
+	TimerPriority m_priority = TimerPriority::normal; // set on creation, selects the deadline heap
+	Group* m_group = nullptr;        // owner thread only
+	BasicTimer* m_previousInGroup = nullptr;
+	BasicTimer* m_nextInGroup = nullptr;
 };
+
+/** timer of TimerManager */
+using Timer = BasicTimer<FunctionClockPolicy>;
+
+// The manager is only needed complete where the members are instantiated, which is behind TimerManager.hpp
+
+template <typename ClockPolicy, typename Duration>
+BasicTimer<ClockPolicy, Duration>::BasicTimer(Manager& manager, bool singleShot, MissedTickPolicy missedTickPolicy)
+: m_isSingleShot(singleShot)
+, m_missedTickPolicy(missedTickPolicy)
+, m_manager(&manager)
+{}
+
+template <typename ClockPolicy, typename Duration>
+BasicTimer<ClockPolicy, Duration>::~BasicTimer()
+{
+	if (m_group)
+	{
+		m_group->removeTimer(*this);
+	}
+	if (m_manager)
+	{
+		m_manager->unregisterTimer(*this);
+	}
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimer<ClockPolicy, Duration>::stop()
+{
+	if (m_manager and m_manager->isForeignThread())
+	{
+		m_manager->postStop(*this);
+		return;
+	}
+	if (m_running)
+	{
+		m_running = false;
+		if (m_manager)
+		{
+			m_manager->unscheduleTimer(*this);
+		}
+	}
+}
+
+template <typename ClockPolicy, typename Duration>
+bool BasicTimer<ClockPolicy, Duration>::isRunning() const
+{
+	return m_running;
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimer<ClockPolicy, Duration>::setTimeoutCallback(std::function<void()> callback)
+{
+	// an empty std::function must not count as callback
+	setTimeoutCallback(callback ? InlineCallback(std::move(callback)) : InlineCallback());
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimer<ClockPolicy, Duration>::setTimeoutCallback(InlineCallback callback)
+{
+	if (m_manager and m_manager->isForeignThread())
+	{
+		m_manager->postTimeoutCallback(*this, std::move(callback));
+		return;
+	}
+	lockTimeoutCallback();
+	m_timeoutCallback = std::move(callback);
+	m_timeoutCallbackReplaced = true;
+	unlockTimeoutCallback();
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimer<ClockPolicy, Duration>::invokeTimeoutCallback()
+{
+	while (m_callbackRunning.exchange(true, std::memory_order_acquire))
+	{
+		std::this_thread::yield();
+	}
+	// the callback leaves its slot while it runs, a callback replacing itself must not destroy the running one
+	lockTimeoutCallback();
+	auto callback = std::move(m_timeoutCallback);
+	m_timeoutCallbackReplaced = false;
+	unlockTimeoutCallback();
+	if (callback)
+	{
+		callback();
+	}
+	lockTimeoutCallback();
+	if (not m_timeoutCallbackReplaced)
+	{
+		m_timeoutCallback = std::move(callback);
+	}
+	unlockTimeoutCallback();
+	m_callbackRunning.store(false, std::memory_order_release);
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimer<ClockPolicy, Duration>::lockTimeoutCallback()
+{
+	while (m_callbackLock.exchange(true, std::memory_order_acquire))
+	{
+		std::this_thread::yield();
+	}
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimer<ClockPolicy, Duration>::unlockTimeoutCallback()
+{
+	m_callbackLock.store(false, std::memory_order_release);
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimer<ClockPolicy, Duration>::start(Duration duration)
+{
+	start(duration, Duration::zero());
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimer<ClockPolicy, Duration>::start(Duration duration, Duration slack)
+{
+	if (m_manager and m_manager->isForeignThread())
+	{
+		m_manager->postStart(*this, duration, slack);
+		return;
+	}
+	if (m_running or duration == Duration::zero())
+	{
+		return;
+	}
+	m_duration = duration;
+	m_slack = slack;
+	m_running = true;
+	m_expireTime = m_deadline = coalesceDeadline(now() + duration, slack);
+	if (m_manager)
+	{
+		m_manager->scheduleTimer(*this);
+	}
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimer<ClockPolicy, Duration>::startAt(Duration expireTime, Duration period)
+{
+	if (m_manager and m_manager->isForeignThread())
+	{
+		m_manager->postStartAt(*this, expireTime, period);
+		return;
+	}
+	if (m_running or (not m_isSingleShot and period <= Duration::zero()))
+	{
+		return;
+	}
+	// the following periods restart from expireTime without slack, so they stay on its grid
+	m_duration = m_isSingleShot ? startAtDuration(expireTime - now(), m_duration) : period;
+	m_slack = Duration::zero();
+	m_running = true;
+	m_expireTime = m_deadline = expireTime;
+	if (m_manager)
+	{
+		m_manager->scheduleTimer(*this);
+	}
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimer<ClockPolicy, Duration>::startAligned(Duration period, Duration phase)
+{
+	if (m_manager and m_manager->isForeignThread())
+	{
+		m_manager->postStartAligned(*this, period, phase);
+		return;
+	}
+	if (period <= Duration::zero())
+	{
+		return;
+	}
+	startAt(nextAlignedTime(now(), period, phase), period);
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimer<ClockPolicy, Duration>::restart(Duration duration)
+{
+	if (m_manager and m_manager->isForeignThread())
+	{
+		m_manager->postRestart(*this, duration);
+		return;
+	}
+	if (not m_running or duration == Duration::zero())
+	{
+		stop();
+		start(duration, m_slack);
+		return;
+	}
+	m_duration = duration;
+	m_deadline = coalesceDeadline(now() + duration, m_slack);
+	// a later deadline stays lazy, poll moves the timer when m_expireTime comes up
+	if (m_deadline < m_expireTime)
+	{
+		m_expireTime = m_deadline;
+		if (m_manager)
+		{
+			m_manager->rescheduleTimer(*this);
+		}
+	}
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimer<ClockPolicy, Duration>::touch()
+{
+	if (m_manager and m_manager->isForeignThread())
+	{
+		m_manager->postTouch(*this);
+		return;
+	}
+	restart(m_duration);
+}
+
+template <typename ClockPolicy, typename Duration>
+bool BasicTimer<ClockPolicy, Duration>::expired() const
+{
+	return m_expired;
+}
+
+template <typename ClockPolicy, typename Duration>
+Duration BasicTimer<ClockPolicy, Duration>::getRemainingTime() const
+{
+	if (m_running)
+	{
+		return m_deadline - now();
+	}
+	else
+	{
+		return Duration::zero();
+	}
+}
+
+template <typename ClockPolicy, typename Duration>
+MissedTickPolicy BasicTimer<ClockPolicy, Duration>::missedTickPolicy() const
+{
+	return m_missedTickPolicy;
+}
+
+template <typename ClockPolicy, typename Duration>
+std::uint64_t BasicTimer<ClockPolicy, Duration>::missedTicks() const
+{
+	return m_missedTicks;
+}
+
+template <typename ClockPolicy, typename Duration>
+Duration BasicTimer<ClockPolicy, Duration>::now() const
+{
+	if (m_group and m_group->isPaused())
+	{
+		return m_group->m_pausedAt;
+	}
+	if (m_manager)
+	{
+		return m_manager->m_timeBase.now();
+	}
+	return m_detachedClock->now();
+}
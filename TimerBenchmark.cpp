@@ -0,0 +1,355 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ScanTimerManager.hpp"
+#include "TimerManager.hpp"
+#include "TimingWheelTimerManager.hpp"
+
+// Single threaded benchmark of the timer managers. All managers run on a virtual clock which is moved by the
+// workloads, so every engine sees exactly the same expirations. Usage: timer_benchmark [maxTimers]
+
+namespace {
+
+std::size_t allocationCount = 0;
+
+std::chrono::milliseconds virtualTime = 0ms;
+
+/** static clock policy of BasicTimerManager, reads the virtual time */
+struct VirtualClockPolicy
+{
+    std::chrono::milliseconds now() const
+    {
+        return virtualTime;
+    }
+};
+
+using Clock = std::chrono::steady_clock;
+
+struct Result
+{
+    double operations = 0;
+    Clock::duration elapsed = Clock::duration::zero();
+    std::size_t allocations = 0;
+    std::vector<Clock::duration> pollLatencies;
+};
+
+/** measures time and allocations of a workload section */
+class Measurement
+{
+public:
+    explicit Measurement(Result& result)
+    : m_result(result)
+    , m_allocationsAtStart(allocationCount)
+    , m_begin(Clock::now())
+    {}
+
+    ~Measurement()
+    {
+        m_result.elapsed += Clock::now() - m_begin;
+        m_result.allocations += allocationCount - m_allocationsAtStart;
+    }
+
+private:
+    Result& m_result;
+    const std::size_t m_allocationsAtStart;
+    const Clock::time_point m_begin;
+};
+
+void timedPoll(ITimerManager& manager, Result& result)
+{
+    const auto begin = Clock::now();
+    manager.poll();
+    result.pollLatencies.push_back(Clock::now() - begin);
+}
+
+std::vector<std::shared_ptr<ITimer>> createTimers(ITimerManager& manager, std::size_t count, bool tick)
+{
+    std::vector<std::shared_ptr<ITimer>> timers;
+    timers.reserve(count);
+    for (std::size_t index = 0; index < count; ++index)
+    {
+        timers.push_back(tick ? manager.createTickTimer() : manager.createSingleShotTimer());
+    }
+    return timers;
+}
+
+/** create, arm and release a timer while `timers` other timers are armed */
+Result createDestroyChurn(ITimerManager& manager, std::size_t timers)
+{
+    constexpr int iterations = 200000;
+    auto background = createTimers(manager, timers, false);
+    for (std::size_t index = 0; index < timers; ++index)
+    {
+        background[index]->start(1h + std::chrono::milliseconds(index));
+    }
+    int calls = 0;
+    auto churn = [&](int count) {
+        for (int iteration = 0; iteration < count; ++iteration)
+        {
+            auto timer = manager.createSingleShotTimer();
+            timer->setTimeoutCallback([&calls]() { ++calls; });
+            timer->start(1s + std::chrono::milliseconds(iteration % 1000));
+        }
+    };
+    churn(1000);
+
+    Result result;
+    {
+        Measurement measurement(result);
+        churn(iterations);
+    }
+    result.operations = iterations;
+    return result;
+}
+
+/** stop and start armed timers with random durations */
+Result startStopChurn(ITimerManager& manager, std::size_t timers)
+{
+    constexpr int iterations = 1000000;
+    std::mt19937 random(1);
+    std::uniform_int_distribution<int> durations(1000, 3600000);
+    auto armed = createTimers(manager, timers, false);
+    for (auto& timer : armed)
+    {
+        timer->start(std::chrono::milliseconds(durations(random)));
+    }
+
+    Result result;
+    {
+        Measurement measurement(result);
+        for (int iteration = 0; iteration < iterations; ++iteration)
+        {
+            auto& timer = armed[iteration % timers];
+            timer->stop();
+            timer->start(std::chrono::milliseconds(durations(random)));
+        }
+    }
+    result.operations = iterations;
+    return result;
+}
+
+/** poll every virtual millisecond while tick timers with durations of 1ms..10s expire */
+Result pollCost(ITimerManager& manager, std::size_t timers)
+{
+    constexpr int polls = 5000;
+    std::mt19937 random(2);
+    std::uniform_int_distribution<int> durations(1, 10000);
+    int calls = 0;
+    auto armed = createTimers(manager, timers, true);
+    for (auto& timer : armed)
+    {
+        timer->setTimeoutCallback([&calls]() { ++calls; });
+        timer->start(std::chrono::milliseconds(durations(random)));
+    }
+
+    Result result;
+    result.pollLatencies.reserve(polls);
+    {
+        Measurement measurement(result);
+        for (int poll = 0; poll < polls; ++poll)
+        {
+            virtualTime += 1ms;
+            timedPoll(manager, result);
+        }
+    }
+    result.operations = polls;
+    return result;
+}
+
+/** connection keepalive: every virtual millisecond 1000 random connections see traffic and restart their 30s timeout.
+ * Timers of idle connections expire. Restarts by stop and start or by touch */
+Result keepalive(ITimerManager& manager, std::size_t timers, bool touch)
+{
+    constexpr int polls = 2000;
+    constexpr int restartsPerPoll = 1000;
+    std::mt19937 random(3);
+    std::uniform_int_distribution<std::size_t> connections(0, timers - 1);
+    int expirations = 0;
+    auto armed = createTimers(manager, timers, false);
+    for (std::size_t index = 0; index < timers; ++index)
+    {
+        armed[index]->setTimeoutCallback([&expirations]() { ++expirations; });
+        armed[index]->start(30s - std::chrono::milliseconds(index % 30000));
+    }
+
+    Result result;
+    result.pollLatencies.reserve(polls);
+    {
+        Measurement measurement(result);
+        for (int poll = 0; poll < polls; ++poll)
+        {
+            for (int restart = 0; restart < restartsPerPoll; ++restart)
+            {
+                auto& timer = armed[connections(random)];
+                if (touch)
+                {
+                    timer->touch();
+                    continue;
+                }
+                timer->stop();
+                timer->start(30s);
+            }
+            virtualTime += 1ms;
+            timedPoll(manager, result);
+        }
+    }
+    result.operations = double(polls) * restartsPerPoll;
+    return result;
+}
+
+Result keepaliveStopStart(ITimerManager& manager, std::size_t timers)
+{
+    return keepalive(manager, timers, false);
+}
+
+Result keepaliveTouch(ITimerManager& manager, std::size_t timers)
+{
+    return keepalive(manager, timers, true);
+}
+
+/** all timers expire in the same poll, every callback re-arms its timer */
+Result callbackStorm(ITimerManager& manager, std::size_t timers)
+{
+    constexpr int storms = 5;
+    std::uint64_t work = 0;
+    auto armed = createTimers(manager, timers, false);
+    for (std::size_t index = 0; index < timers; ++index)
+    {
+        auto timer = armed[index].get();
+        timer->setTimeoutCallback([timer, index, &work]() {
+            work += index;
+            timer->start(1s);
+        });
+        timer->start(1s);
+    }
+
+    Result result;
+    result.pollLatencies.reserve(storms);
+    {
+        Measurement measurement(result);
+        for (int storm = 0; storm < storms; ++storm)
+        {
+            virtualTime += 1s;
+            timedPoll(manager, result);
+        }
+    }
+    result.operations = double(storms) * timers;
+    return result;
+}
+
+double percentile(std::vector<Clock::duration>& latencies, double fraction)
+{
+    auto position = latencies.begin() + std::size_t(fraction * (latencies.size() - 1));
+    std::nth_element(latencies.begin(), position, latencies.end());
+    return std::chrono::duration<double, std::nano>(*position).count();
+}
+
+void print(const char* engine, const char* workload, std::size_t timers, Result& result)
+{
+    const double nanoseconds = std::chrono::duration<double, std::nano>(result.elapsed).count();
+    std::printf("%-18s %-14s %9zu %12.1f %10.3f", engine, workload, timers, nanoseconds / result.operations,
+                result.allocations / result.operations);
+    if (result.pollLatencies.empty())
+    {
+        std::printf(" %12s %12s %12s\n", "-", "-", "-");
+        return;
+    }
+    std::printf(" %12.0f %12.0f %12.0f\n", percentile(result.pollLatencies, 0.5), percentile(result.pollLatencies, 0.99),
+                percentile(result.pollLatencies, 0.999));
+}
+
+struct Engine
+{
+    const char* name;
+    std::function<std::shared_ptr<ITimerManager>()> create;
+};
+
+struct Workload
+{
+    const char* name;
+    Result (*run)(ITimerManager& manager, std::size_t timers);
+    std::vector<std::size_t> sizes;
+};
+
+} // namespace
+
+// counts allocations of the benchmark, reported per operation
+void* operator new(std::size_t size)
+{
+    ++allocationCount;
+    if (auto block = std::malloc(size ? size : 1))
+    {
+        return block;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* block) noexcept
+{
+    std::free(block);
+}
+
+void operator delete(void* block, std::size_t) noexcept
+{
+    std::free(block);
+}
+
+int main(int argc, char** argv)
+{
+    const std::size_t maxTimers = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    auto virtualClock = []() { return virtualTime; };
+
+    const std::vector<Engine> engines = {
+        {"TimerManager", [&]() { return std::make_shared<TimerManager>(virtualClock); }},
+        {"BasicTimerManager", []() { return std::make_shared<BasicTimerManager<VirtualClockPolicy>>(); }},
+        {"TimerManager+stats",
+         [&]() {
+             auto manager = std::make_shared<TimerManager>(virtualClock);
+             manager->enableMetrics();
+             return manager;
+         }},
+        {"TimingWheel", [&]() { return std::make_shared<TimingWheelTimerManager>(virtualClock); }},
+        {"Scan", [&]() { return std::make_shared<ScanTimerManager>(virtualClock); }},
+        {"Scan scalar",
+         [&]() { return std::make_shared<ScanTimerManager>(virtualClock, ScanTimerManager::Kernel::scalar); }},
+    };
+    const std::vector<Workload> workloads = {
+        {"create/destroy", createDestroyChurn, {10, 10000, 1000000}},
+        {"start/stop", startStopChurn, {10, 10000, 1000000}},
+        {"poll", pollCost, {10, 100, 1000, 10000, 100000, 1000000}},
+        {"keepalive", keepaliveStopStart, {10000, 1000000}},
+        {"keepalive touch", keepaliveTouch, {10000, 1000000}},
+        {"callback storm", callbackStorm, {1000, 100000, 1000000}},
+    };
+
+    // ns/op: create/destroy per timer, start/stop per restart, poll per poll, keepalive per restart or touch,
+    // callback storm per callback. Poll latencies in ns.
+    std::printf("%-18s %-14s %9s %12s %10s %12s %12s %12s\n", "engine", "workload", "timers", "ns/op", "allocs/op",
+                "poll p50", "poll p99", "poll p999");
+    for (const auto& workload : workloads)
+    {
+        for (auto timers : workload.sizes)
+        {
+            if (timers > maxTimers)
+            {
+                continue;
+            }
+            for (const auto& engine : engines)
+            {
+                virtualTime = 0ms;
+                auto manager = engine.create();
+                auto result = workload.run(*manager, timers);
+                print(engine.name, workload.name, timers, result);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,330 @@
+#pragma once
+
+// C++20 awaitables on top of BasicTimerManager. The rest of the library is C++14, only translation units
+// including this header need --std=c++20. Without coroutine support the header is empty.
+#if defined(__cpp_impl_coroutine) and __has_include(<coroutine>)
+#include "TimerManager.hpp"
+#include "TimerPool.hpp"
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+/* Coroutines waiting for a timer are resumed directly by poll, in expiry order like timeout callbacks, and see the
+ * expire time as current time. So co_await sleepFor(manager, 100ms) in a loop keeps its period and a fast forward
+ * runs all sleeps falling into it immediately. Awaiting allocates nothing: the timer lives in the awaiter inside
+ * the coroutine frame. Destroying a suspended coroutine cancels its timers. Owner thread of the manager only.
+ *
+ *     co_await sleepFor(manager, 250ms);
+ *     if (not co_await withTimeout(manager, sleepFor(manager, 1s), 500ms)) { ... timed out ... }
+ *     std::optional<Reply> reply = co_await withTimeout(manager, connection.receive(), 5s);
+ */
+
+/** awaiter of sleepFor */
+template <typename ClockPolicy, typename Duration>
+class SleepAwaiter
+{
+public:
+    using Manager = BasicTimerManager<ClockPolicy, Duration>;
+
+    SleepAwaiter(Manager& manager, Duration duration)
+    : m_manager(&manager)
+    , m_duration(duration)
+    {}
+
+    /** movable until awaited, e.g. into withTimeout */
+    SleepAwaiter(SleepAwaiter&& other)
+    : m_manager(other.m_manager)
+    , m_duration(other.m_duration)
+    {}
+
+    bool await_ready() const noexcept
+    {
+        return m_duration <= Duration::zero();
+    }
+
+    void await_suspend(std::coroutine_handle<> continuation)
+    {
+        m_timer.emplace(*m_manager);
+        m_timer->start(m_duration, [continuation]() { continuation.resume(); });
+    }
+
+    void await_resume() const noexcept {}
+
+    /** stops a suspended sleep without resuming the waiting coroutine, see withTimeout */
+    void cancel()
+    {
+        m_timer.reset();
+    }
+
+private:
+    Manager* m_manager;
+    Duration m_duration;
+    std::optional<typename Manager::EmbeddedTimer> m_timer; // created when suspending, the awaiter does not move then
+};
+
+/** suspend the calling coroutine for duration of the manager's time, any duration converting implicitly */
+template <typename ClockPolicy, typename Duration>
+SleepAwaiter<ClockPolicy, Duration> sleepFor(BasicTimerManager<ClockPolicy, Duration>& manager,
+                                             std::type_identity_t<Duration> duration)
+{
+    return SleepAwaiter<ClockPolicy, Duration>(manager, duration);
+}
+
+namespace detail {
+
+/** the awaiter co_await uses for operation: the result of its operator co_await, else operation itself */
+template <typename Operation>
+decltype(auto) awaiterOf(Operation& operation)
+{
+    if constexpr (requires { operation.operator co_await(); })
+    {
+        return operation.operator co_await();
+    }
+    else if constexpr (requires { operator co_await(operation); })
+    {
+        return operator co_await(operation);
+    }
+    else
+    {
+        return (operation);
+    }
+}
+
+template <typename Operation>
+using AwaiterOf = decltype(awaiterOf(std::declval<Operation&>()));
+
+/** Coroutine awaiting the operation of withTimeout, so the timeout can resume the waiting coroutine first.
+ * Frames are recycled per thread: after warming up an await allocates nothing. */
+class TimeoutRace
+{
+public:
+    struct promise_type
+    {
+        std::coroutine_handle<> continuation; // resumed when the race completes after suspending the caller
+
+        TimeoutRace get_return_object()
+        {
+            return TimeoutRace(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        /** suspends, the frame is destroyed by the awaiter of withTimeout */
+        auto final_suspend() noexcept
+        {
+            struct ResumeContinuation
+            {
+                bool await_ready() noexcept
+                {
+                    return false;
+                }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> race) noexcept
+                {
+                    auto continuation = race.promise().continuation;
+                    return continuation ? continuation : std::noop_coroutine();
+                }
+
+                void await_resume() noexcept {}
+            };
+            return ResumeContinuation{};
+        }
+
+        void return_void() noexcept {}
+
+        // the race catches the exceptions of the operation
+        void unhandled_exception() noexcept
+        {
+            std::terminate();
+        }
+
+        static void* operator new(std::size_t bytes)
+        {
+            return framePool().allocate(bytes);
+        }
+
+        static void operator delete(void* frame, std::size_t bytes)
+        {
+            framePool().deallocate(frame, bytes);
+        }
+
+    private:
+        static TimerPool& framePool()
+        {
+            struct ThreadPool
+            {
+                TimerPool* pool = new TimerPool;
+
+                ~ThreadPool()
+                {
+                    pool->release();
+                }
+            };
+            static thread_local ThreadPool threadPool;
+            return *threadPool.pool;
+        }
+    };
+
+    using Handle = std::coroutine_handle<promise_type>;
+
+    TimeoutRace() = default;
+
+    explicit TimeoutRace(Handle handle)
+    : m_handle(handle)
+    {}
+
+    Handle handle() const
+    {
+        return m_handle;
+    }
+
+private:
+    Handle m_handle;
+};
+
+} // namespace detail
+
+/** Awaiter of withTimeout. Awaiting yields whether the operation completed in time, or for operations with a
+ * result a std::optional of it, empty on timeout. Exceptions of the operation are rethrown. */
+template <typename ClockPolicy, typename Duration, typename Operation>
+class TimeoutAwaiter
+{
+public:
+    using Manager = BasicTimerManager<ClockPolicy, Duration>;
+    using Awaiter = detail::AwaiterOf<std::remove_reference_t<Operation>>;
+    using OperationResult = std::remove_cvref_t<decltype(std::declval<std::remove_reference_t<Awaiter>&>().await_resume())>;
+    using Result = std::conditional_t<std::is_void<OperationResult>::value, bool, std::optional<OperationResult>>;
+
+    // An awaiter returned by operator co_await lives in the race and goes with it, as does one moved in here with
+    // this awaiter. A referenced one outlives both, it has to be cancelled explicitly.
+    static constexpr bool cancellable = requires(std::remove_reference_t<Operation>& operation) { operation.cancel(); };
+    static_assert(not std::is_lvalue_reference<Operation>::value or not std::is_reference<Awaiter>::value or cancellable,
+                  "withTimeout references lvalue operations, they need cancel() to stop waiting on timeout");
+
+    template <typename Argument>
+    TimeoutAwaiter(Manager& manager, Argument&& operation, Duration timeout)
+    : m_operation(std::forward<Argument>(operation))
+    , m_timer(manager)
+    , m_timeout(timeout)
+    {}
+
+    TimeoutAwaiter(const TimeoutAwaiter&) = delete;
+    TimeoutAwaiter& operator=(const TimeoutAwaiter&) = delete;
+
+    /** destroying the race cancels a pending operation */
+    ~TimeoutAwaiter()
+    {
+        if (m_race)
+        {
+            cancelRace();
+        }
+    }
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> caller)
+    {
+        m_race = race(*this).handle();
+        m_race.resume();
+        if (m_completed)
+        {
+            // completed without suspending, the caller continues right away
+            return false;
+        }
+        m_caller = caller;
+        m_race.promise().continuation = caller;
+        m_timer.start(m_timeout, [this]() { onTimeout(); });
+        return true;
+    }
+
+    Result await_resume()
+    {
+        if (m_exception)
+        {
+            std::rethrow_exception(m_exception);
+        }
+        if constexpr (std::is_void<OperationResult>::value)
+        {
+            return m_completed;
+        }
+        else
+        {
+            return std::move(m_result);
+        }
+    }
+
+private:
+    static detail::TimeoutRace race(TimeoutAwaiter& awaiter)
+    {
+        try
+        {
+            if constexpr (std::is_void<OperationResult>::value)
+            {
+                co_await awaiter.m_operation;
+            }
+            else
+            {
+                awaiter.m_result.emplace(co_await awaiter.m_operation);
+            }
+        }
+        catch (...)
+        {
+            awaiter.m_exception = std::current_exception();
+        }
+        // the final suspend of the race resumes the caller
+        awaiter.m_completed = true;
+        awaiter.m_timer.stop();
+    }
+
+    void onTimeout()
+    {
+        cancelRace();
+        m_caller.resume();
+    }
+
+    /** the operation is still suspended in the race unless completed, destroying the race cancels it */
+    void cancelRace()
+    {
+        if constexpr (cancellable)
+        {
+            if (not m_completed)
+            {
+                m_operation.cancel();
+            }
+        }
+        m_race.destroy();
+        m_race = nullptr;
+    }
+
+    Operation m_operation; // a reference for lvalue operations
+    typename Manager::EmbeddedTimer m_timer;
+    Duration m_timeout;
+    detail::TimeoutRace::Handle m_race;
+    std::coroutine_handle<> m_caller;
+    bool m_completed = false;
+    std::optional<std::conditional_t<std::is_void<OperationResult>::value, bool, OperationResult>> m_result;
+    std::exception_ptr m_exception;
+};
+
+/** Await operation, an awaiter with await_ready, await_suspend and await_resume or an awaitable with operator co_await,
+ * for at most timeout. On timeout the suspended operation is destroyed, which has to cancel it, as it does for the
+ * awaiters of this header. An rvalue operation is moved into the awaiter, an lvalue one is referenced: an lvalue
+ * awaiter outlives the timeout, so it is stopped by its cancel(), SleepAwaiter has one. */
+template <typename ClockPolicy, typename Duration, typename Operation>
+TimeoutAwaiter<ClockPolicy, Duration, Operation> withTimeout(BasicTimerManager<ClockPolicy, Duration>& manager,
+                                                             Operation&& operation,
+                                                             std::type_identity_t<Duration> timeout)
+{
+    return TimeoutAwaiter<ClockPolicy, Duration, Operation>(manager, std::forward<Operation>(operation), timeout);
+}
+#endif
@@ -0,0 +1,143 @@
+#pragma once
+
+#ifdef __linux__
+#include "TimerManager.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <initializer_list>
+#include <system_error>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+/** Drives a timer manager from an epoll, poll or select event loop instead of polling on a fixed interval.
+ * A timerfd is kept armed to the earliest expiry of the manager: it is reprogrammed when timers are started,
+ * stopped or expire and disarmed while nothing runs or the manager is paused. Due work, e.g. commands of other
+ * threads in cross thread mode, is signalled by an eventfd, which other threads may write without racing the
+ * reprogramming. Both are combined in one epoll fd. Add fd() to the event loop for readability and call
+ * onReadable() when it is reported. Like waitAndPoll the timerfd assumes the clock policy of the manager advances
+ * with real time. Fast forward expires timers right away and reprograms the timerfd.
+ * The manager has to outlive the driver, both belong to the owner thread of the manager. Create the driver before
+ * timers are handed to other threads. */
+template <typename ClockPolicy, typename Duration = std::chrono::milliseconds>
+class BasicTimerFdDriver
+{
+public:
+    using Manager = BasicTimerManager<ClockPolicy, Duration>;
+
+    /** throws std::system_error when the file descriptors cannot be created */
+    explicit BasicTimerFdDriver(Manager& manager);
+
+    ~BasicTimerFdDriver();
+
+    /** readable when timers are due or other threads posted commands */
+    int fd() const
+    {
+        return m_epollFd;
+    }
+
+    /** consume the readiness of fd() and poll the manager, which reprograms the fd afterwards */
+    void onReadable();
+
+private:
+    BasicTimerFdDriver(const BasicTimerFdDriver&) = delete;
+    BasicTimerFdDriver& operator=(const BasicTimerFdDriver&) = delete;
+
+    /** arm the timerfd to fire after timeout, noExpiry() disarms it. Zero signals the eventfd, from any thread */
+    void program(Duration timeout);
+
+    void closeAll();
+
+    Manager& m_manager;
+    int m_timerFd = -1;    // CLOCK_MONOTONIC, armed to the earliest expiry
+    int m_eventFd = -1;    // polls as soon as possible
+    int m_epollFd = -1;    // readable when one of them is
+};
+
+/** event loop driver of TimerManager */
+using TimerFdDriver = BasicTimerFdDriver<FunctionClockPolicy>;
+
+template <typename ClockPolicy, typename Duration>
+BasicTimerFdDriver<ClockPolicy, Duration>::BasicTimerFdDriver(Manager& manager)
+: m_manager(manager)
+{
+    m_timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    m_eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    auto ok = m_timerFd >= 0 and m_eventFd >= 0 and m_epollFd >= 0;
+    for (auto fd : {m_timerFd, m_eventFd})
+    {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        ok = ok and epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event) == 0;
+    }
+    if (not ok)
+    {
+        const auto error = errno;
+        closeAll();
+        throw std::system_error(error, std::generic_category(), "TimerFdDriver");
+    }
+    m_manager.setExpiryObserver([this](Duration timeout) { program(timeout); });
+    program(m_manager.timeUntilNextExpiry());
+}
+
+template <typename ClockPolicy, typename Duration>
+BasicTimerFdDriver<ClockPolicy, Duration>::~BasicTimerFdDriver()
+{
+    m_manager.setExpiryObserver(nullptr);
+    closeAll();
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerFdDriver<ClockPolicy, Duration>::onReadable()
+{
+    // the counters are of no interest, the manager knows which timers are due. Both fds are non-blocking
+    std::uint64_t counter;
+    for (auto fd : {m_timerFd, m_eventFd})
+    {
+        while (read(fd, &counter, sizeof(counter)) < 0 and errno == EINTR)
+        {
+        }
+    }
+    m_manager.poll();
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerFdDriver<ClockPolicy, Duration>::program(Duration timeout)
+{
+    if (timeout <= Duration::zero())
+    {
+        const std::uint64_t one = 1;
+        while (write(m_eventFd, &one, sizeof(one)) < 0 and errno == EINTR)
+        {
+        }
+        return;
+    }
+    // an all zero value disarms
+    itimerspec spec{};
+    if (timeout != Manager::noExpiry())
+    {
+        const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout).count();
+        spec.it_value.tv_sec = static_cast<time_t>(nanoseconds / 1000000000);
+        spec.it_value.tv_nsec = static_cast<long>(nanoseconds % 1000000000);
+    }
+    timerfd_settime(m_timerFd, 0, &spec, nullptr);
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerFdDriver<ClockPolicy, Duration>::closeAll()
+{
+    for (auto fd : {m_epollFd, m_eventFd, m_timerFd})
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+}
+#endif
@@ -0,0 +1,214 @@
+#pragma once
+
+#include "ITimerGroup.hpp"
+
+#include <cstddef>
+#include <memory>
+
+/** group operations a manager may have to queue for its owner thread, see BasicTimerGroup */
+enum class TimerGroupOperation
+{
+    stopAll,
+    pause,
+    resume,
+    destroy
+};
+
+/** Timer group of BasicTimerManager and TimingWheelTimerManager. Its timers are linked into an intrusive list, so
+ * bulk operations touch only them. Pausing takes the running timers out of the scheduler and remembers the pause
+ * time, their time stands still there. Resuming shifts their expire times by the paused period, like the manager's
+ * pause moves its time offset, and schedules them again.
+ *
+ * The manager provides to its friend: m_timeBase, createGroupTimer(singleShot, policy, group), unscheduleTimer(timer),
+ * shiftTimer(timer, shift), postGroupOperation(group, operation) returning true when queued for the owner thread
+ * and registerGroup/unregisterGroup. The timer provides m_group, m_previousInGroup, m_nextInGroup, m_running, stop(). */
+template <typename Manager, typename TimerType, typename Duration>
+class BasicTimerGroup : public IBasicTimerGroup<Duration>,
+                        public std::enable_shared_from_this<BasicTimerGroup<Manager, TimerType, Duration>>
+{
+public:
+    /** deletes groups released on other threads on the owner thread of the manager */
+    struct Deleter
+    {
+        void operator()(BasicTimerGroup* group) const;
+    };
+
+    explicit BasicTimerGroup(Manager& manager);
+
+    /** stops the timers of the group and leaves them on their own */
+    ~BasicTimerGroup();
+
+    std::shared_ptr<IBasicTimer<Duration>> createSingleShotTimer() override;
+
+    std::shared_ptr<IBasicTimer<Duration>> createTickTimer(MissedTickPolicy policy = MissedTickPolicy::fireAll) override;
+
+    void stopAll() override;
+
+    void pause() override;
+
+    void resume() override;
+
+    bool isPaused() const override;
+
+    std::size_t size() const override;
+
+    friend Manager;
+    friend TimerType;
+
+private:
+    BasicTimerGroup(const BasicTimerGroup&) = delete;
+    BasicTimerGroup& operator=(const BasicTimerGroup&) = delete;
+
+    void addTimer(TimerType& timer);
+    void removeTimer(TimerType& timer);
+
+    Manager* m_manager; // reset when the manager is deleted first
+    TimerType* m_firstTimer = nullptr;
+    std::size_t m_size = 0;
+    bool m_paused = false;
+    Duration m_pausedAt = Duration::zero(); // manager time of the pause, the time of the group's timers meanwhile
+    BasicTimerGroup* m_previousGroup = nullptr; // intrusive list of the groups of the manager
+    BasicTimerGroup* m_nextGroup = nullptr;
+};
+
+template <typename Manager, typename TimerType, typename Duration>
+void BasicTimerGroup<Manager, TimerType, Duration>::Deleter::operator()(BasicTimerGroup* group) const
+{
+    if (group->m_manager and group->m_manager->postGroupOperation(*group, TimerGroupOperation::destroy))
+    {
+        return;
+    }
+    delete group;
+}
+
+template <typename Manager, typename TimerType, typename Duration>
+BasicTimerGroup<Manager, TimerType, Duration>::BasicTimerGroup(Manager& manager)
+: m_manager(&manager)
+{
+    m_manager->registerGroup(*this);
+}
+
+template <typename Manager, typename TimerType, typename Duration>
+BasicTimerGroup<Manager, TimerType, Duration>::~BasicTimerGroup()
+{
+    while (m_firstTimer)
+    {
+        auto timer = m_firstTimer;
+        timer->stop();
+        removeTimer(*timer);
+    }
+    if (m_manager)
+    {
+        m_manager->unregisterGroup(*this);
+    }
+}
+
+template <typename Manager, typename TimerType, typename Duration>
+std::shared_ptr<IBasicTimer<Duration>> BasicTimerGroup<Manager, TimerType, Duration>::createSingleShotTimer()
+{
+    return m_manager->createGroupTimer(true, MissedTickPolicy::fireAll, *this);
+}
+
+template <typename Manager, typename TimerType, typename Duration>
+std::shared_ptr<IBasicTimer<Duration>> BasicTimerGroup<Manager, TimerType, Duration>::createTickTimer(MissedTickPolicy policy)
+{
+    return m_manager->createGroupTimer(false, policy, *this);
+}
+
+template <typename Manager, typename TimerType, typename Duration>
+void BasicTimerGroup<Manager, TimerType, Duration>::stopAll()
+{
+    if (m_manager and m_manager->postGroupOperation(*this, TimerGroupOperation::stopAll))
+    {
+        return;
+    }
+    for (auto timer = m_firstTimer; timer; timer = timer->m_nextInGroup)
+    {
+        timer->stop();
+    }
+}
+
+template <typename Manager, typename TimerType, typename Duration>
+void BasicTimerGroup<Manager, TimerType, Duration>::pause()
+{
+    if (not m_manager or m_manager->postGroupOperation(*this, TimerGroupOperation::pause) or m_paused)
+    {
+        return;
+    }
+    m_pausedAt = m_manager->m_timeBase.now();
+    m_paused = true;
+    // running timers stay running, they are only out of the scheduler
+    for (auto timer = m_firstTimer; timer; timer = timer->m_nextInGroup)
+    {
+        if (timer->m_running)
+        {
+            m_manager->unscheduleTimer(*timer);
+        }
+    }
+}
+
+template <typename Manager, typename TimerType, typename Duration>
+void BasicTimerGroup<Manager, TimerType, Duration>::resume()
+{
+    if (not m_manager or m_manager->postGroupOperation(*this, TimerGroupOperation::resume) or not m_paused)
+    {
+        return;
+    }
+    m_paused = false;
+    // the paused period is taken out of the time line of the group's timers
+    const auto shift = m_manager->m_timeBase.now() - m_pausedAt;
+    for (auto timer = m_firstTimer; timer; timer = timer->m_nextInGroup)
+    {
+        if (timer->m_running)
+        {
+            m_manager->shiftTimer(*timer, shift);
+        }
+    }
+}
+
+template <typename Manager, typename TimerType, typename Duration>
+bool BasicTimerGroup<Manager, TimerType, Duration>::isPaused() const
+{
+    return m_paused;
+}
+
+template <typename Manager, typename TimerType, typename Duration>
+std::size_t BasicTimerGroup<Manager, TimerType, Duration>::size() const
+{
+    return m_size;
+}
+
+template <typename Manager, typename TimerType, typename Duration>
+void BasicTimerGroup<Manager, TimerType, Duration>::addTimer(TimerType& timer)
+{
+    timer.m_group = this;
+    timer.m_previousInGroup = nullptr;
+    timer.m_nextInGroup = m_firstTimer;
+    if (m_firstTimer)
+    {
+        m_firstTimer->m_previousInGroup = &timer;
+    }
+    m_firstTimer = &timer;
+    ++m_size;
+}
+
+template <typename Manager, typename TimerType, typename Duration>
+void BasicTimerGroup<Manager, TimerType, Duration>::removeTimer(TimerType& timer)
+{
+    if (timer.m_previousInGroup)
+    {
+        timer.m_previousInGroup->m_nextInGroup = timer.m_nextInGroup;
+    }
+    else
+    {
+        m_firstTimer = timer.m_nextInGroup;
+    }
+    if (timer.m_nextInGroup)
+    {
+        timer.m_nextInGroup->m_previousInGroup = timer.m_previousInGroup;
+    }
+    timer.m_group = nullptr;
+    timer.m_previousInGroup = nullptr;
+    timer.m_nextInGroup = nullptr;
+    --m_size;
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <vector>
+
+/** Indexed 4-ary min-heap of armed timers ordered by expire time.
+ * Every timer stores its own position (TimerType::m_heapIndex), so removal of an arbitrary timer is O(log n)
+ * and looking at the earliest deadline is O(1). Timers with equal expire time are ordered by creation. */
+template <typename TimerType>
+class BasicTimerHeap
+{
+public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    bool empty() const
+    {
+        return m_timers.empty();
+    }
+
+    std::size_t size() const
+    {
+        return m_timers.size();
+    }
+
+    /** earliest expiring timer. Heap must not be empty */
+    TimerType* top() const
+    {
+        return m_timers.front();
+    }
+
+    /** insert a timer which is not part of the heap yet */
+    void push(TimerType& timer);
+
+    /** remove a timer from the heap. Does nothing when timer is not part of the heap */
+    void remove(TimerType& timer);
+
+    /** restore heap order after the expire time of a contained timer changed */
+    void update(TimerType& timer)
+    {
+        siftUp(timer.m_heapIndex);
+        siftDown(timer.m_heapIndex);
+    }
+
+    bool contains(const TimerType& timer) const
+    {
+        return timer.m_heapIndex < m_timers.size() and m_timers[timer.m_heapIndex] == &timer;
+    }
+
+    void clear();
+
+    /** call visitor for every timer expiring at or before time, in heap order. Costs O(number of visited timers),
+     * does not allocate */
+    template <typename Time, typename Visitor>
+    void visitExpiringUntil(Time time, Visitor visitor) const;
+
+private:
+    static constexpr std::size_t arity = 4;
+    // a 4-ary heap indexed by std::size_t is at most one level per two bits deep
+    static constexpr std::size_t maxDepth = sizeof(std::size_t) * 8 / 2 + 1;
+
+    static bool isEarlier(const TimerType& lhs, const TimerType& rhs)
+    {
+        if (lhs.m_expireTime != rhs.m_expireTime)
+        {
+            return lhs.m_expireTime < rhs.m_expireTime;
+        }
+        return lhs.m_sequence < rhs.m_sequence;
+    }
+
+    void place(std::size_t index, TimerType* timer)
+    {
+        m_timers[index] = timer;
+        timer->m_heapIndex = index;
+    }
+
+    void siftUp(std::size_t index);
+    void siftDown(std::size_t index);
+
+    std::vector<TimerType*> m_timers;
+};
+
+template <typename TimerType>
+constexpr std::size_t BasicTimerHeap<TimerType>::npos;
+
+template <typename TimerType>
+constexpr std::size_t BasicTimerHeap<TimerType>::arity;
+
+template <typename TimerType>
+constexpr std::size_t BasicTimerHeap<TimerType>::maxDepth;
+
+template <typename TimerType>
+void BasicTimerHeap<TimerType>::push(TimerType& timer)
+{
+    m_timers.push_back(&timer);
+    timer.m_heapIndex = m_timers.size() - 1;
+    siftUp(timer.m_heapIndex);
+}
+
+template <typename TimerType>
+void BasicTimerHeap<TimerType>::remove(TimerType& timer)
+{
+    if (not contains(timer))
+    {
+        return;
+    }
+    const auto index = timer.m_heapIndex;
+    auto last = m_timers.back();
+    m_timers.pop_back();
+    timer.m_heapIndex = npos;
+    if (last != &timer)
+    {
+        // fill the gap with the last element and restore heap order in the direction it violates
+        place(index, last);
+        siftUp(index);
+        siftDown(last->m_heapIndex);
+    }
+}
+
+template <typename TimerType>
+void BasicTimerHeap<TimerType>::clear()
+{
+    for (auto timer : m_timers)
+    {
+        timer->m_heapIndex = npos;
+    }
+    m_timers.clear();
+}
+
+template <typename TimerType>
+template <typename Time, typename Visitor>
+void BasicTimerHeap<TimerType>::visitExpiringUntil(Time time, Visitor visitor) const
+{
+    // children never expire before their parent, subtrees of later timers are skipped
+    if (m_timers.empty() or m_timers.front()->m_expireTime > time)
+    {
+        return;
+    }
+    // depth first, the stack holds the unvisited siblings of every level on the path, at most arity per level
+    std::array<std::size_t, arity * maxDepth> pending;
+    std::size_t pendingCount = 0;
+    pending[pendingCount++] = 0;
+    while (pendingCount > 0)
+    {
+        const auto index = pending[--pendingCount];
+        visitor(*m_timers[index]);
+        const auto firstChild = index * arity + 1;
+        const auto lastChild = std::min(firstChild + arity, m_timers.size());
+        for (auto child = firstChild; child < lastChild; ++child)
+        {
+            if (m_timers[child]->m_expireTime <= time)
+            {
+                pending[pendingCount++] = child;
+            }
+        }
+    }
+}
+
+template <typename TimerType>
+void BasicTimerHeap<TimerType>::siftUp(std::size_t index)
+{
+    auto timer = m_timers[index];
+    while (index > 0)
+    {
+        const auto parent = (index - 1) / arity;
+        if (not isEarlier(*timer, *m_timers[parent]))
+        {
+            break;
+        }
+        place(index, m_timers[parent]);
+        index = parent;
+    }
+    place(index, timer);
+}
+
+template <typename TimerType>
+void BasicTimerHeap<TimerType>::siftDown(std::size_t index)
+{
+    auto timer = m_timers[index];
+    const auto count = m_timers.size();
+    while (true)
+    {
+        const auto firstChild = index * arity + 1;
+        if (firstChild >= count)
+        {
+            break;
+        }
+        const auto lastChild = std::min(firstChild + arity, count);
+        auto earliest = firstChild;
+        for (auto child = firstChild + 1; child < lastChild; ++child)
+        {
+            if (isEarlier(*m_timers[child], *m_timers[earliest]))
+            {
+                earliest = child;
+            }
+        }
+        if (not isEarlier(*m_timers[earliest], *timer))
+        {
+            break;
+        }
+        place(index, m_timers[earliest]);
+        index = earliest;
+    }
+    place(index, timer);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+
+template <typename ClockPolicy, typename Duration>
+class BasicTimerManager;
+
+/** Handle of a timer in the handle table of a BasicTimerManager, see createSingleShotTimerId. A 64 bit value: slot
+ * index in the low, generation of the slot in the high half. The generation changes whenever the slot is freed or
+ * reused, so a handle of a destroyed timer stays stale, also when its slot holds another timer meanwhile.
+ * A default constructed handle is never valid. */
+class TimerId
+{
+public:
+    TimerId() = default;
+
+    explicit operator bool() const
+    {
+        return m_value != 0;
+    }
+
+    std::uint64_t value() const
+    {
+        return m_value;
+    }
+
+    friend bool operator==(TimerId left, TimerId right)
+    {
+        return left.m_value == right.m_value;
+    }
+
+    friend bool operator!=(TimerId left, TimerId right)
+    {
+        return left.m_value != right.m_value;
+    }
+
+    template <typename ClockPolicy, typename Duration>
+    friend class BasicTimerManager;
+
+private:
+    TimerId(std::uint32_t index, std::uint32_t generation)
+    : m_value((std::uint64_t(generation) << 32) | index)
+    {}
+
+    std::uint32_t index() const
+    {
+        return std::uint32_t(m_value);
+    }
+
+    std::uint32_t generation() const
+    {
+        return std::uint32_t(m_value >> 32);
+    }
+
+    std::uint64_t m_value = 0;
+};
@@ -1,46 +1,1663 @@
 #pragma once
 
 #include "ITimerManager.hpp"
+#include "InlineCallback.hpp"
+#include "MpscQueue.hpp"
+#include "TimeBase.hpp"
+#include "WakeupSignal.hpp"
+#include "Timer.hpp"
+#include "TimerHeap.hpp"
+#include "TimerId.hpp"
+#include "TimerMetrics.hpp"
+#include "TimerPool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <array>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
-#include <list>
+#include <limits>
+#include <new>
+#include <thread>
+#include <vector>
 
-class Timer;
-
-extern std::chrono::milliseconds getChronoSteadyClockTicks(void);
-
-class TimerManager : public ITimerManager
+/** Timer manager with the clock as static policy, see ClockPolicy.hpp. Timers read the time through the
+ * manager without any indirect call, so with a stateless policy it is a single clock read plus an offset.
+ * Duration is the resolution of all times, e.g. BasicTimerManager<SteadyClockPolicy, std::chrono::microseconds>
+ * for sub-millisecond timers. */
+template <typename ClockPolicy, typename Duration = std::chrono::milliseconds>
+class BasicTimerManager : public IBasicTimerManager<Duration>
 {
 public:
-    using SteadyTickCallbackType = std::function<std::chrono::milliseconds(void)>;
+    using SteadyTickCallbackType = typename BasicTimeBase<ClockPolicy, Duration>::SteadyTickCallbackType;
+
+    BasicTimerManager(ClockPolicy clock = ClockPolicy());
+
+    ~BasicTimerManager();
 
-    TimerManager(SteadyTickCallbackType steadyTickProvider = getChronoSteadyClockTicks);
+    std::shared_ptr<IBasicTimer<Duration>> createSingleShotTimer() override;
 
-    ~TimerManager();
+    std::shared_ptr<IBasicTimer<Duration>> createTickTimer(MissedTickPolicy policy = MissedTickPolicy::fireAll) override;
 
-    std::shared_ptr<ITimer> createSingleShotTimer() override;
+    /** Timers of a dispatch class. Due timers of a higher class expire before those of lower classes in the same
+     * poll, within a class they keep expire time order. Each class has its own deadline heap, so this costs no
+     * sorting, only a look at the top of each heap per expiry. */
+    std::shared_ptr<IBasicTimer<Duration>> createSingleShotTimer(TimerPriority priority);
 
-    std::shared_ptr<ITimer> createTickTimer() override;
+    std::shared_ptr<IBasicTimer<Duration>> createTickTimer(TimerPriority priority,
+                                                           MissedTickPolicy policy = MissedTickPolicy::fireAll);
 
-    void fastForward(std::chrono::milliseconds milliseconds) override;
+    /** Bounds the starvation of lower classes: a due timer expires at the latest after about limit expiries of other
+     * classes that it was passed over for, also across polls. Default 8, 1 alternates between the due classes. */
+    void setStarvationLimit(std::size_t limit);
+
+    /** In cross thread mode group operations of other threads are queued like those of timers */
+    std::shared_ptr<IBasicTimerGroup<Duration>> createTimerGroup() override;
+
+    void fastForward(Duration duration) override;
 
     void poll() override;
 
+    struct PollResult
+    {
+        std::size_t expired = 0; // timers expired by this call
+        std::size_t overdue = 0; // timers still due at the poll time, left for the next poll
+    };
+
+    /** Bounded poll: like poll, but returns after maxExpirations expired timers. Overdue timers stay in the deadline
+     * index with their expire times, the next poll of any kind continues with them in expiry order before later ones.
+     * Each callback sees the expire time of its timer as current time, as in poll. A tick timer behind by several
+     * periods expires once per period, so a stall or a long fast forward is caught up over several bounded polls.
+     * Counting the overdue timers costs O(overdue) when the poll stopped early. */
+    PollResult poll(std::size_t maxExpirations);
+
+    /** Bounded poll by real time: returns when budget elapsed after an expiry, at least one timer expires when due.
+     * Reads the steady clock once per expiry. */
+    PollResult pollFor(std::chrono::nanoseconds budget);
+
+    /** current time of the manager, the time line of runUntil and ITimer::startAt */
+    Duration now() const;
+
+    /* Virtual time simulation: time jumps from one expire time straight to the next and each expiry is handled by a
+     * poll at exactly its expire time, so the order is the one of poll. Each step costs O(log n) in the running
+     * timers. The clock is not read while simulating: the time stands still as if paused, a manager not paused
+     * continues from the reached time afterwards, the real time spent is taken out like a paused period.
+     * The expiry observer is told once at the end. Not allowed in callbacks. */
+
+    /** move to the earliest expire time and expire all timers due then. False when no timer is running */
+    bool step();
+
+    /** expire all timers due until time in expiry order, then move to time if it lies ahead */
+    void runUntil(Duration time);
+
+    /** step until no timer is running, which never happens while tick timers run. Returns the number of steps */
+    std::size_t runUntilIdle();
+
+    using ExpiryTrace = std::function<void(Duration expireTime, const IBasicTimer<Duration>& timer)>;
+
+    /** Call trace for every expiring timer in poll, right before its callback, e.g. to log simulations. Timers of
+     * EmbeddedTimer and the handle table are traced as well. Pass nullptr to remove it. */
+    void setExpiryTrace(ExpiryTrace trace);
+
     void pause() override;
 
     void resume() override;
 
+    /** Let the time of the manager run at rate times its clock from now on, e.g. 10.0 to replay a recorded day in a
+     * tenth of it. Timers keep their deadlines in manager time, timers outliving the manager keep the rate. waitAndPoll
+     * and the expiry observer wait in clock time. Not positive rates are ignored, as are calls during poll */
+    void rescale(double rate);
+
+    Duration timeUntilNextExpiry() const override;
+
+    void waitAndPoll(Duration maxWait) override;
+
+    void wakeup() override;
+
+    /** Cross thread mode: the owner thread, by default the calling one, is the one polling this manager.
+     * start, stop and setTimeoutCallback called on timers from other threads are queued lock-free and executed
+     * at the beginning of the next poll, durations count from there. Calls from the owner thread take the direct path.
+     * Timers may also be created on other threads, they are registered by the next poll.
+     * Timers created afterwards may be released on other threads, they are deleted by the owner thread.
+     * All other operations stay restricted to the owner thread. Enable before timers are handed to other threads,
+     * the manager has to outlive their use on other threads. */
+    void enableCrossThreadCommands(std::thread::id ownerThread = std::this_thread::get_id());
+
+    using CallbackDispatcher = std::function<void(const std::function<void()>& callback)>;
+
+    /** Hand timeout callbacks of expired timers to dispatcher instead of calling them inside poll.
+     * A dispatched callback runs after its timer has been restarted or stopped, so timers (re)started by the
+     * callback count from the time it runs. The dispatched function keeps the timer alive and calls the callback the
+     * timer has when it runs, calls for one timer are serialized. Pass nullptr to call callbacks in poll again. */
+    void setCallbackDispatcher(CallbackDispatcher dispatcher);
+
+    using CallbackExecutor = std::function<void(std::uint64_t orderingKey, std::function<void()> callback)>;
+
+    /** Like setCallbackDispatcher, for executors running callbacks concurrently, e.g. a ThreadPoolExecutor:
+     *     manager.setCallbackExecutor([&pool](std::uint64_t key, std::function<void()> callback) {
+     *         pool.execute(key, std::move(callback)); });
+     * Callbacks with equal ordering key have to run one after the other in the order they were executed, poll hands
+     * them over in expiry order. The key of a timer is unique unless set by setOrderingKey. Poll only computes
+     * expirations then. Without executor callbacks run in poll, which keeps fastForward deterministic in tests.
+     * Call it on the owner thread: it enables cross thread commands for it if not done yet, so timer operations of
+     * callbacks on other threads are queued. The reference a callback keeps on its timer is released on the owner
+     * thread as well. */
+    void setCallbackExecutor(CallbackExecutor executor);
+
+    /** Give a timer of this manager an ordering key shared with other timers, whose callbacks then keep their
+     * expiry order among each other with a callback executor. Timers of other managers are ignored. */
+    void setOrderingKey(IBasicTimer<Duration>& timer, std::uint64_t key);
+
+    /** Single shot timer living inside another object, e.g. an awaiter in a coroutine frame (see TimerCoroutines.hpp),
+     * instead of being shared: creating and starting it allocates nothing. Its callback is called in poll, also with a
+     * callback dispatcher, and may destroy the timer: poll does not touch it afterwards. Owner thread only. */
+    class EmbeddedTimer
+    {
+    public:
+        explicit EmbeddedTimer(BasicTimerManager& manager);
+
+        EmbeddedTimer(const EmbeddedTimer&) = delete;
+        EmbeddedTimer& operator=(const EmbeddedTimer&) = delete;
+
+        /** callback is called once when duration elapsed, starting a running timer again moves it */
+        void start(Duration duration, InlineCallback callback);
+
+        void stop();
+
+        bool isRunning() const;
+
+    private:
+        BasicTimer<ClockPolicy, Duration> m_timer;
+    };
+
+    /** Handle API, an alternative to shared timers without reference counting: timers are owned by the manager and
+     * addressed by TimerId, which indexes a dense handle table. Operations on stale handles are ignored, remaining
+     * returns zero for them. Callbacks are called in poll like those of EmbeddedTimer, also with a callback executor,
+     * and may destroy their own timer. Tick timers keep their period and missed tick policy. Owner thread only. */
+    TimerId createSingleShotTimerId();
+
+    TimerId createTickTimerId(MissedTickPolicy policy = MissedTickPolicy::fireAll);
+
+    /** stops and deletes the timer, its handle becomes stale */
+    void destroy(TimerId id);
+
+    void setTimeoutCallback(TimerId id, InlineCallback callback);
+
+    void start(TimerId id, Duration duration, Duration slack = Duration::zero());
+
+    void restart(TimerId id, Duration duration);
+
+    void stop(TimerId id);
+
+    Duration remaining(TimerId id) const;
+
+    bool isRunning(TimerId id) const;
+
+    /** false for stale handles */
+    bool isValid(TimerId id) const;
+
+    using ExpiryObserver = std::function<void(Duration timeUntilNextExpiry)>;
+
+    /** Notify observer whenever the time until the earliest expiry may have changed outside of a poll: a timer was
+     * started, stopped or restarted earlier, at the end of every poll and on pause or resume. It gets noExpiry()
+     * while paused or without running timers. Called on the owner thread, except for commands posted by other threads:
+     * they call it on the posting thread with zero, the next poll executes them. Lets event loops arm a
+     * system timer instead of polling on a fixed interval, see TimerFdDriver. Pass nullptr to remove it. */
+    void setExpiryObserver(ExpiryObserver observer);
+
+    /** Collect metrics from now on, see TimerMetrics. Lateness, expirations per poll and timer counts cost a few ns
+     * per expiry. With measureDurations callbacks and polls are timed, that is one steady clock read per expiry.
+     * Disabled metrics cost a branch per expiry. The returned metrics may be read from any thread. */
+    std::shared_ptr<const TimerMetrics> enableMetrics(bool measureDurations = true);
+
 private:
-    TimerManager(const TimerManager&) = delete;
-    TimerManager(TimerManager&&) = delete;
-
-    SteadyTickCallbackType m_steadyTickCallback;
-    SteadyTickCallbackType m_originalSteadyTickCallback; // needed to restore
-    std::list<std::weak_ptr<Timer>> m_timers;
-    std::chrono::milliseconds m_pollTimeStamp = 0ms;
-    std::chrono::milliseconds m_fastForwardOffset = 0ms;
-    std::chrono::milliseconds m_pausingTime = 0ms;
-    std::chrono::milliseconds m_pausingOffset = 0ms;
-    bool m_paused = false;
-    bool m_isCurrentlyPolling = false;
+    using Timer = BasicTimer<ClockPolicy, Duration>;
+    using Group = typename Timer::Group;
+    friend Timer;
+    friend Group;
+
+    struct TimerCommand
+    {
+        enum class Type
+        {
+            create,
+            start,
+            startAt,
+            startAligned,
+            restart,
+            touch,
+            stop,
+            setTimeoutCallback,
+            destroy,
+            release,
+            createGroup,
+            groupOperation
+        };
+
+        Type type = Type::stop;
+        std::weak_ptr<Timer> timer;
+        Timer* rawTimer = nullptr; // for create and destroy, the timer is not referenced by shared pointers then
+        std::shared_ptr<Timer> reference; // for release, dropped on the owner thread
+        TimerPool* pool = nullptr; // for destroy
+        std::weak_ptr<Group> group;  // for create and groupOperation
+        Group* rawGroup = nullptr;   // for createGroup and destroying a group
+        TimerGroupOperation groupOperation = TimerGroupOperation::stopAll;
+        Duration duration = Duration::zero();
+        Duration slack = Duration::zero();
+        Duration anchor = Duration::zero(); // expire time of startAt, phase of startAligned
+        InlineCallback callback;
+    };
+
+    /** deleter of timers in cross thread mode, pool is nullptr for timers created by other threads */
+    struct TimerDeleter
+    {
+        TimerPool* pool;
+
+        void operator()(Timer* timer) const;
+    };
+
+    BasicTimerManager(const BasicTimerManager&) = delete;
+    BasicTimerManager(BasicTimerManager&&) = delete;
+
+    std::shared_ptr<Timer> createTimer(bool singleShot,
+                                       MissedTickPolicy policy = MissedTickPolicy::fireAll,
+                                       Group* group = nullptr,
+                                       TimerPriority priority = TimerPriority::normal);
+
+    std::shared_ptr<IBasicTimer<Duration>> createGroupTimer(bool singleShot, MissedTickPolicy policy, Group& group);
+
+    /** timers of paused groups are running, but not scheduled */
+    static bool isFrozen(const Timer& timer)
+    {
+        return timer.m_group and timer.m_group->isPaused();
+    }
+
+    /** called by a resumed group, moves the deadline of a running timer by the paused period and schedules it */
+    void shiftTimer(Timer& timer, Duration shift);
+
+    /** queue a group operation of another thread, false on the owner thread */
+    bool postGroupOperation(Group& group, TimerGroupOperation operation);
+
+    void registerGroup(Group& group);
+    void linkGroup(Group& group);
+    void unregisterGroup(Group& group);
+    void executeGroupOperation(TimerCommand& command);
+
+    void registerTimer(Timer& timer);
+
+    /** expire a timer of EmbeddedTimer, which its callback may destroy */
+    void expireEmbeddedTimer(Timer& timer);
+
+    /** slot of the handle table, the generation is odd while the slot holds a timer */
+    struct HandleSlot
+    {
+        Timer* timer = nullptr;
+        std::uint32_t generation = 0;
+    };
+
+    TimerId createTimerId(bool singleShot, MissedTickPolicy policy);
+
+    /** timer of a handle, nullptr when stale */
+    Timer* handleTimer(TimerId id) const;
+
+    /** expire a timer of the handle table, which its callback may destroy */
+    void expireHandleTimer(Timer& timer, Duration currentTime);
+
+    /** called by timer when it was started. Adds it to the deadline index */
+    void scheduleTimer(Timer& timer);
+
+    /** called by timer when its expire time was moved earlier */
+    void rescheduleTimer(Timer& timer);
+
+    /** called by timer when it was stopped. Removes it from the deadline index */
+    void unscheduleTimer(Timer& timer);
+
+    /** called by timer on destruction */
+    void unregisterTimer(Timer& timer);
+
+    /** true when timer operations have to be queued for the owner thread */
+    bool isForeignThread() const
+    {
+        return m_crossThreadCommands and std::this_thread::get_id() != m_ownerThread;
+    }
+
+    void postStart(Timer& timer, Duration duration, Duration slack);
+    void postStartAt(Timer& timer, Duration expireTime, Duration period);
+    void postStartAligned(Timer& timer, Duration period, Duration phase);
+    void postRestart(Timer& timer, Duration duration);
+    void postTouch(Timer& timer);
+    void postStop(Timer& timer);
+    void postTimeoutCallback(Timer& timer, InlineCallback callback);
+    void postCommand(TimerCommand command);
+
+    /** tell the expiry observer, if any, about a changed earliest expiry */
+    void notifyExpiryObserver();
+    void processCommands();
+
+    PollResult pollBounded(std::size_t maxExpirations, std::chrono::nanoseconds budget);
+
+    /** expire time of the earliest running timer after moving restarted ones, false when no timer is running */
+    bool nextExpireTime(Duration& expireTime);
+
+    BasicTimerHeap<Timer>& deadlines(const Timer& timer);
+
+    /** running timer with the earliest expire time over all classes, nullptr when none is running */
+    Timer* earliestTimer() const;
+
+    /** top of deadlines when it is due at currentTime, after moving restarted timers to their deadline */
+    static Timer* dueTop(BasicTimerHeap<Timer>& deadlines, Duration currentTime);
+
+    /** class of the next timer to expire at currentTime, the highest due one unless a lower one starves.
+     * timerPriorityCount when no timer is due */
+    std::size_t nextDuePriority(Duration currentTime);
+
+    /** counts the expiry of a timer of priority for the other due classes */
+    void passOver(std::size_t priority, Duration currentTime);
+
+    /** Current time for the callback of an expiring timer: its expire time, but not earlier than that of a callback
+     * before in the same poll, which a higher class may have taken ahead. So time never goes back for callbacks and
+     * timers they (re)start. Tick timers re-arm from their own expire time anyway, they keep their period. */
+    Duration callbackTime(const Timer& timer);
+
+    /** freezes time and keeps observer notifications for the end, see step */
+    class Simulation
+    {
+    public:
+        explicit Simulation(BasicTimerManager& manager);
+        ~Simulation();
+
+    private:
+        BasicTimerManager& m_manager;
+        const bool m_wasPaused;
+        const bool m_wasSimulating; // runUntilIdle steps inside its own simulation
+    };
+
+    static void destroyTimer(Timer* timer, TimerPool* pool);
+
+    /** drops a reference held on another thread, e.g. by a dispatched callback, on the owner thread */
+    static void releaseOnOwnerThread(std::shared_ptr<Timer> timer);
+
+    BasicTimeBase<ClockPolicy, Duration> m_timeBase;
+    WakeupSignal m_wakeupSignal;
+    TimerPool* m_pool;             // timer storage, released on destruction
+    Timer* m_firstTimer = nullptr; // intrusive list of all living timers, needed to detach them on destruction
+    Group* m_firstGroup = nullptr; // intrusive list of all living groups, detached on destruction as well
+    std::vector<HandleSlot> m_handles;       // handle table, timers come from the pool
+    std::vector<std::uint32_t> m_freeHandles; // free slots of the handle table
+    std::array<BasicTimerHeap<Timer>, timerPriorityCount> m_deadlines; // running timers per class by expire time
+    std::array<std::size_t, timerPriorityCount> m_passedOver{}; // expiries of other classes while due
+    std::size_t m_starvationLimit = 8;
+    Duration m_latestCallbackTime = Duration::min(); // of the running poll, see callbackTime
+    std::uint64_t m_timerSequence = 0;
+    std::uint64_t m_liveTimers = 0;
+    std::atomic<std::uint64_t> m_deadTimers{0}; // released on other threads, not deleted yet
+    bool m_crossThreadCommands = false;
+    std::thread::id m_ownerThread;
+    MpscQueue<TimerCommand> m_commands; // timer operations from other threads
+    CallbackExecutor m_callbackExecutor;
+    ExpiryObserver m_expiryObserver;
+    ExpiryTrace m_expiryTrace;
+    bool m_simulating = false;
+    std::shared_ptr<TimerMetrics> m_metrics; // nullptr while disabled
+    bool m_measureDurations = false;
 };
+
+/** type erased clock, the manager for any std::function time source */
+using TimerManager = BasicTimerManager<FunctionClockPolicy>;
+
+extern template class BasicTimer<FunctionClockPolicy>;
+extern template class BasicTimerManager<FunctionClockPolicy>;
+
+template <typename ClockPolicy, typename Duration>
+BasicTimerManager<ClockPolicy, Duration>::BasicTimerManager(ClockPolicy clock)
+: m_timeBase(std::move(clock))
+, m_pool(new TimerPool)
+{}
+
+template <typename ClockPolicy, typename Duration>
+BasicTimerManager<ClockPolicy, Duration>::~BasicTimerManager()
+{
+    // remove local dependencies in created timers. -> Timers can exist after Lifetime of
+    // TimerManager using provided clock and calculated offset. In normal case of operation
+    // getChronoSteadyClockTicks() + current offset is used.
+    // Pending operations of other threads are done here, the deleting thread takes over ownership for that.
+    m_ownerThread = std::this_thread::get_id();
+    processCommands();
+    // timers of the handle table are owned here
+    for (auto& slot : m_handles)
+    {
+        if (slot.timer)
+        {
+            destroy(TimerId(std::uint32_t(&slot - m_handles.data()), slot.generation));
+        }
+    }
+    auto replacementSteadyTickCallback = std::make_shared<const typename Timer::DetachedClock>(m_timeBase.detachedClock());
+
+    auto timer = m_firstTimer;
+    while (timer)
+    {
+        auto next = timer->m_nextTimer;
+        timer->m_detachedClock = replacementSteadyTickCallback;
+        timer->m_manager = nullptr;
+        timer->m_previousTimer = nullptr;
+        timer->m_nextTimer = nullptr;
+        timer = next;
+    }
+    m_firstTimer = nullptr;
+    for (auto group = m_firstGroup; group; group = group->m_nextGroup)
+    {
+        group->m_manager = nullptr;
+    }
+    m_firstGroup = nullptr;
+    for (auto& deadlines : m_deadlines)
+    {
+        deadlines.clear();
+    }
+    // the pool lives on until the remaining timers are deleted
+    m_pool->release();
+}
+
+template <typename ClockPolicy, typename Duration>
+std::shared_ptr<IBasicTimer<Duration>> BasicTimerManager<ClockPolicy, Duration>::createSingleShotTimer()
+{
+    return createTimer(true);
+}
+
+template <typename ClockPolicy, typename Duration>
+std::shared_ptr<IBasicTimer<Duration>> BasicTimerManager<ClockPolicy, Duration>::createTickTimer(MissedTickPolicy policy)
+{
+    return createTimer(false, policy);
+}
+
+template <typename ClockPolicy, typename Duration>
+std::shared_ptr<IBasicTimer<Duration>> BasicTimerManager<ClockPolicy, Duration>::createSingleShotTimer(TimerPriority priority)
+{
+    return createTimer(true, MissedTickPolicy::fireAll, nullptr, priority);
+}
+
+template <typename ClockPolicy, typename Duration>
+std::shared_ptr<IBasicTimer<Duration>> BasicTimerManager<ClockPolicy, Duration>::createTickTimer(TimerPriority priority,
+                                                                                                 MissedTickPolicy policy)
+{
+    return createTimer(false, policy, nullptr, priority);
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::setStarvationLimit(std::size_t limit)
+{
+    m_starvationLimit = std::max<std::size_t>(limit, 1);
+}
+
+template <typename ClockPolicy, typename Duration>
+std::shared_ptr<IBasicTimerGroup<Duration>> BasicTimerManager<ClockPolicy, Duration>::createTimerGroup()
+{
+    // groups created on other threads are linked by the owner thread, see registerGroup
+    return std::shared_ptr<Group>(new Group(*this), typename Group::Deleter());
+}
+
+template <typename ClockPolicy, typename Duration>
+std::shared_ptr<IBasicTimer<Duration>> BasicTimerManager<ClockPolicy, Duration>::createGroupTimer(bool singleShot,
+                                                                                                  MissedTickPolicy policy,
+                                                                                                  Group& group)
+{
+    return createTimer(singleShot, policy, &group);
+}
+
+template <typename ClockPolicy, typename Duration>
+std::shared_ptr<BasicTimer<ClockPolicy, Duration>> BasicTimerManager<ClockPolicy, Duration>::createTimer(bool singleShot,
+                                                                                                         MissedTickPolicy policy,
+                                                                                                         Group* group,
+                                                                                                         TimerPriority priority)
+{
+    // timer and shared pointer control block come from the pool, which is owner thread only
+    std::shared_ptr<Timer> timer;
+    if (isForeignThread())
+    {
+        timer = std::shared_ptr<Timer>(new Timer(*this, singleShot, policy), TimerDeleter{nullptr});
+    }
+    else if (m_crossThreadCommands)
+    {
+        // timers may be released on other threads, the deleter hands them over to the owner thread
+        TimerPoolAllocator<Timer> allocator(*m_pool);
+        auto block = allocator.allocate(1);
+        timer = std::shared_ptr<Timer>(new (block) Timer(*this, singleShot, policy), TimerDeleter{m_pool}, allocator);
+    }
+    else
+    {
+        timer = std::allocate_shared<Timer>(TimerPoolAllocator<Timer>(*m_pool), *this, singleShot, policy);
+    }
+    // fixed before the timer is scheduled, it selects the deadline heap
+    timer->m_priority = priority;
+    if (isForeignThread())
+    {
+        TimerCommand command;
+        command.type = TimerCommand::Type::create;
+        command.rawTimer = timer.get();
+        if (group)
+        {
+            command.group = group->shared_from_this();
+        }
+        postCommand(std::move(command));
+    }
+    else
+    {
+        registerTimer(*timer);
+        if (group)
+        {
+            group->addTimer(*timer);
+        }
+    }
+    return timer;
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::registerTimer(Timer& timer)
+{
+    // timers need to be stored here for detaching them when manager is deleted.
+    // The sequence number lets timers with equal expire time expire in creation order.
+    timer.m_nextTimer = m_firstTimer;
+    if (m_firstTimer)
+    {
+        m_firstTimer->m_previousTimer = &timer;
+    }
+    m_firstTimer = &timer;
+    timer.m_sequence = m_timerSequence++;
+    timer.m_orderingKey = timer.m_sequence;
+    ++m_liveTimers;
+}
+
+template <typename ClockPolicy, typename Duration>
+BasicTimerManager<ClockPolicy, Duration>::EmbeddedTimer::EmbeddedTimer(BasicTimerManager& manager)
+: m_timer(manager, true)
+{
+    m_timer.m_embedded = true;
+    manager.registerTimer(m_timer);
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::EmbeddedTimer::start(Duration duration, InlineCallback callback)
+{
+    m_timer.stop();
+    m_timer.m_timeoutCallback = std::move(callback);
+    m_timer.start(duration);
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::EmbeddedTimer::stop()
+{
+    m_timer.stop();
+}
+
+template <typename ClockPolicy, typename Duration>
+bool BasicTimerManager<ClockPolicy, Duration>::EmbeddedTimer::isRunning() const
+{
+    return m_timer.isRunning();
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::expireEmbeddedTimer(Timer& timer)
+{
+    m_timeBase.setPollTimeStamp(callbackTime(timer));
+    timer.stop();
+    auto callback = std::move(timer.m_timeoutCallback);
+    if (callback)
+    {
+        callback();
+    }
+}
+
+template <typename ClockPolicy, typename Duration>
+TimerId BasicTimerManager<ClockPolicy, Duration>::createSingleShotTimerId()
+{
+    return createTimerId(true, MissedTickPolicy::fireAll);
+}
+
+template <typename ClockPolicy, typename Duration>
+TimerId BasicTimerManager<ClockPolicy, Duration>::createTickTimerId(MissedTickPolicy policy)
+{
+    return createTimerId(false, policy);
+}
+
+template <typename ClockPolicy, typename Duration>
+TimerId BasicTimerManager<ClockPolicy, Duration>::createTimerId(bool singleShot, MissedTickPolicy policy)
+{
+    std::uint32_t index;
+    if (m_freeHandles.empty())
+    {
+        index = std::uint32_t(m_handles.size());
+        m_handles.emplace_back();
+    }
+    else
+    {
+        index = m_freeHandles.back();
+        m_freeHandles.pop_back();
+    }
+    auto& slot = m_handles[index];
+    slot.timer = new (m_pool->allocate(sizeof(Timer))) Timer(*this, singleShot, policy);
+    ++slot.generation;
+    slot.timer->m_handle = TimerId(index, slot.generation);
+    registerTimer(*slot.timer);
+    return slot.timer->m_handle;
+}
+
+template <typename ClockPolicy, typename Duration>
+BasicTimer<ClockPolicy, Duration>* BasicTimerManager<ClockPolicy, Duration>::handleTimer(TimerId id) const
+{
+    if (id.index() >= m_handles.size())
+    {
+        return nullptr;
+    }
+    const auto& slot = m_handles[id.index()];
+    return slot.generation == id.generation() ? slot.timer : nullptr;
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::destroy(TimerId id)
+{
+    auto timer = handleTimer(id);
+    if (not timer)
+    {
+        return;
+    }
+    auto& slot = m_handles[id.index()];
+    slot.timer = nullptr;
+    ++slot.generation;
+    m_freeHandles.push_back(id.index());
+    timer->~Timer();
+    m_pool->deallocate(timer, sizeof(Timer));
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::setTimeoutCallback(TimerId id, InlineCallback callback)
+{
+    if (auto timer = handleTimer(id))
+    {
+        timer->setTimeoutCallback(std::move(callback));
+    }
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::start(TimerId id, Duration duration, Duration slack)
+{
+    if (auto timer = handleTimer(id))
+    {
+        timer->start(duration, slack);
+    }
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::restart(TimerId id, Duration duration)
+{
+    if (auto timer = handleTimer(id))
+    {
+        timer->restart(duration);
+    }
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::stop(TimerId id)
+{
+    if (auto timer = handleTimer(id))
+    {
+        timer->stop();
+    }
+}
+
+template <typename ClockPolicy, typename Duration>
+Duration BasicTimerManager<ClockPolicy, Duration>::remaining(TimerId id) const
+{
+    auto timer = handleTimer(id);
+    return timer ? timer->getRemainingTime() : Duration::zero();
+}
+
+template <typename ClockPolicy, typename Duration>
+bool BasicTimerManager<ClockPolicy, Duration>::isRunning(TimerId id) const
+{
+    auto timer = handleTimer(id);
+    return timer and timer->isRunning();
+}
+
+template <typename ClockPolicy, typename Duration>
+bool BasicTimerManager<ClockPolicy, Duration>::isValid(TimerId id) const
+{
+    return handleTimer(id) != nullptr;
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::expireHandleTimer(Timer& timer, Duration currentTime)
+{
+    const auto id = timer.m_handle;
+    m_timeBase.setPollTimeStamp(callbackTime(timer));
+    timer.stop();
+    auto restartTime = timer.m_expireTime;
+    if (not timer.m_isSingleShot)
+    {
+        restartTime = tickRestartTime(timer.m_missedTickPolicy, timer.m_expireTime, currentTime, timer.m_duration,
+                                      timer.m_missedTicks);
+    }
+    // see Timer::invokeTimeoutCallback, without locking: handle timers are owner thread only
+    auto callback = std::move(timer.m_timeoutCallback);
+    timer.m_timeoutCallbackReplaced = false;
+    if (callback)
+    {
+        callback();
+    }
+    // the callback may have destroyed the timer, its slot may even hold a new one
+    if (handleTimer(id) != &timer)
+    {
+        return;
+    }
+    if (not timer.m_timeoutCallbackReplaced)
+    {
+        timer.m_timeoutCallback = std::move(callback);
+    }
+    if (not timer.m_isSingleShot)
+    {
+        m_timeBase.setPollTimeStamp(restartTime);
+        timer.start(timer.m_duration, timer.m_slack);
+    }
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::scheduleTimer(Timer& timer)
+{
+    if (isFrozen(timer))
+    {
+        return;
+    }
+    deadlines(timer).push(timer);
+    if (m_expiryObserver and earliestTimer() == &timer)
+    {
+        notifyExpiryObserver();
+    }
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::rescheduleTimer(Timer& timer)
+{
+    if (isFrozen(timer))
+    {
+        return;
+    }
+    deadlines(timer).update(timer);
+    if (m_expiryObserver and earliestTimer() == &timer)
+    {
+        notifyExpiryObserver();
+    }
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::unscheduleTimer(Timer& timer)
+{
+    const auto wasEarliest = m_expiryObserver and earliestTimer() == &timer;
+    deadlines(timer).remove(timer);
+    if (m_expiryObserver and wasEarliest)
+    {
+        notifyExpiryObserver();
+    }
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::unregisterTimer(Timer& timer)
+{
+    unscheduleTimer(timer);
+    if (timer.m_previousTimer)
+    {
+        timer.m_previousTimer->m_nextTimer = timer.m_nextTimer;
+    }
+    else
+    {
+        m_firstTimer = timer.m_nextTimer;
+    }
+    if (timer.m_nextTimer)
+    {
+        timer.m_nextTimer->m_previousTimer = timer.m_previousTimer;
+    }
+    timer.m_manager = nullptr;
+    --m_liveTimers;
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::shiftTimer(Timer& timer, Duration shift)
+{
+    timer.m_deadline += shift;
+    timer.m_expireTime = timer.m_deadline;
+    scheduleTimer(timer);
+}
+
+template <typename ClockPolicy, typename Duration>
+bool BasicTimerManager<ClockPolicy, Duration>::postGroupOperation(Group& group, TimerGroupOperation operation)
+{
+    if (not isForeignThread())
+    {
+        return false;
+    }
+    TimerCommand command;
+    command.type = TimerCommand::Type::groupOperation;
+    command.groupOperation = operation;
+    if (operation == TimerGroupOperation::destroy)
+    {
+        command.rawGroup = &group;
+    }
+    else
+    {
+        command.group = group.shared_from_this();
+    }
+    postCommand(std::move(command));
+    return true;
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::executeGroupOperation(TimerCommand& command)
+{
+    if (command.groupOperation == TimerGroupOperation::destroy)
+    {
+        delete command.rawGroup;
+        return;
+    }
+    // operations for groups released in the meantime are dropped
+    auto group = command.group.lock();
+    if (not group)
+    {
+        return;
+    }
+    switch (command.groupOperation)
+    {
+    case TimerGroupOperation::stopAll:
+        group->stopAll();
+        break;
+    case TimerGroupOperation::pause:
+        group->pause();
+        break;
+    case TimerGroupOperation::resume:
+        group->resume();
+        break;
+    case TimerGroupOperation::destroy:
+        break;
+    }
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::registerGroup(Group& group)
+{
+    if (isForeignThread())
+    {
+        // like timers, groups of other threads are linked by the owner thread
+        TimerCommand command;
+        command.type = TimerCommand::Type::createGroup;
+        command.rawGroup = &group;
+        postCommand(std::move(command));
+        return;
+    }
+    linkGroup(group);
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::linkGroup(Group& group)
+{
+    group.m_previousGroup = nullptr;
+    group.m_nextGroup = m_firstGroup;
+    if (m_firstGroup)
+    {
+        m_firstGroup->m_previousGroup = &group;
+    }
+    m_firstGroup = &group;
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::unregisterGroup(Group& group)
+{
+    if (group.m_previousGroup)
+    {
+        group.m_previousGroup->m_nextGroup = group.m_nextGroup;
+    }
+    else
+    {
+        m_firstGroup = group.m_nextGroup;
+    }
+    if (group.m_nextGroup)
+    {
+        group.m_nextGroup->m_previousGroup = group.m_previousGroup;
+    }
+    group.m_manager = nullptr;
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::enableCrossThreadCommands(std::thread::id ownerThread)
+{
+    m_ownerThread = ownerThread;
+    m_crossThreadCommands = true;
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::setCallbackDispatcher(CallbackDispatcher dispatcher)
+{
+    if (not dispatcher)
+    {
+        m_callbackExecutor = nullptr;
+        return;
+    }
+    m_callbackExecutor = [dispatcher](std::uint64_t, std::function<void()> callback) { dispatcher(callback); };
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::setCallbackExecutor(CallbackExecutor executor)
+{
+    // callbacks touching their timer from the executor's threads must not race with poll
+    if (executor and not m_crossThreadCommands)
+    {
+        enableCrossThreadCommands();
+    }
+    m_callbackExecutor = executor;
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::setOrderingKey(IBasicTimer<Duration>& timer, std::uint64_t key)
+{
+    auto ownTimer = dynamic_cast<Timer*>(&timer);
+    if (ownTimer and ownTimer->m_manager == this)
+    {
+        ownTimer->m_orderingKey = key;
+    }
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::setExpiryObserver(ExpiryObserver observer)
+{
+    m_expiryObserver = observer;
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::notifyExpiryObserver()
+{
+    // a running poll or simulation reports once when it ends
+    if (not m_expiryObserver or m_timeBase.isPolling() or m_simulating)
+    {
+        return;
+    }
+    m_expiryObserver(m_timeBase.isPaused() ? this->noExpiry() : m_timeBase.toClockDuration(timeUntilNextExpiry()));
+}
+
+template <typename ClockPolicy, typename Duration>
+std::shared_ptr<const TimerMetrics> BasicTimerManager<ClockPolicy, Duration>::enableMetrics(bool measureDurations)
+{
+    if (not m_metrics)
+    {
+        m_metrics = std::make_shared<TimerMetrics>();
+    }
+    m_measureDurations = measureDurations;
+    return m_metrics;
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::postStart(Timer& timer, Duration duration, Duration slack)
+{
+    TimerCommand command;
+    command.type = TimerCommand::Type::start;
+    command.timer = timer.shared_from_this();
+    command.duration = duration;
+    command.slack = slack;
+    postCommand(std::move(command));
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::postStartAt(Timer& timer, Duration expireTime, Duration period)
+{
+    TimerCommand command;
+    command.type = TimerCommand::Type::startAt;
+    command.timer = timer.shared_from_this();
+    command.duration = period;
+    command.anchor = expireTime;
+    postCommand(std::move(command));
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::postStartAligned(Timer& timer, Duration period, Duration phase)
+{
+    TimerCommand command;
+    command.type = TimerCommand::Type::startAligned;
+    command.timer = timer.shared_from_this();
+    command.duration = period;
+    command.anchor = phase;
+    postCommand(std::move(command));
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::postRestart(Timer& timer, Duration duration)
+{
+    TimerCommand command;
+    command.type = TimerCommand::Type::restart;
+    command.timer = timer.shared_from_this();
+    command.duration = duration;
+    postCommand(std::move(command));
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::postTouch(Timer& timer)
+{
+    TimerCommand command;
+    command.type = TimerCommand::Type::touch;
+    command.timer = timer.shared_from_this();
+    postCommand(std::move(command));
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::postStop(Timer& timer)
+{
+    TimerCommand command;
+    command.type = TimerCommand::Type::stop;
+    command.timer = timer.shared_from_this();
+    postCommand(std::move(command));
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::postTimeoutCallback(Timer& timer, InlineCallback callback)
+{
+    TimerCommand command;
+    command.type = TimerCommand::Type::setTimeoutCallback;
+    command.timer = timer.shared_from_this();
+    command.callback = std::move(callback);
+    postCommand(std::move(command));
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::postCommand(TimerCommand command)
+{
+    m_commands.push(std::move(command));
+    // an earlier timer might have been started, a blocked waitAndPoll has to recalculate its timeout
+    m_wakeupSignal.notifyWaiter();
+    if (m_expiryObserver)
+    {
+        m_expiryObserver(Duration::zero());
+    }
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::processCommands()
+{
+    if (not m_crossThreadCommands)
+    {
+        return;
+    }
+    TimerCommand command;
+    while (m_commands.pop(command))
+    {
+        // a created timer is registered before any command of the releasing thread can arrive
+        if (command.type == TimerCommand::Type::create)
+        {
+            registerTimer(*command.rawTimer);
+            if (auto group = command.group.lock())
+            {
+                group->addTimer(*command.rawTimer);
+            }
+            continue;
+        }
+        if (command.type == TimerCommand::Type::createGroup)
+        {
+            linkGroup(*command.rawGroup);
+            continue;
+        }
+        if (command.type == TimerCommand::Type::groupOperation)
+        {
+            executeGroupOperation(command);
+            continue;
+        }
+        if (command.type == TimerCommand::Type::release)
+        {
+            command.reference = nullptr;
+            continue;
+        }
+        if (command.type == TimerCommand::Type::destroy)
+        {
+            m_deadTimers.fetch_sub(1, std::memory_order_relaxed);
+            destroyTimer(command.rawTimer, command.pool);
+            continue;
+        }
+        // commands for timers released in the meantime are dropped
+        auto timer = command.timer.lock();
+        if (not timer)
+        {
+            continue;
+        }
+        switch (command.type)
+        {
+        case TimerCommand::Type::start:
+            timer->start(command.duration, command.slack);
+            break;
+        case TimerCommand::Type::startAt:
+            timer->startAt(command.anchor, command.duration);
+            break;
+        case TimerCommand::Type::startAligned:
+            timer->startAligned(command.duration, command.anchor);
+            break;
+        case TimerCommand::Type::restart:
+            timer->restart(command.duration);
+            break;
+        case TimerCommand::Type::touch:
+            timer->touch();
+            break;
+        case TimerCommand::Type::stop:
+            timer->stop();
+            break;
+        case TimerCommand::Type::setTimeoutCallback:
+            timer->setTimeoutCallback(std::move(command.callback));
+            break;
+        case TimerCommand::Type::create:
+        case TimerCommand::Type::destroy:
+        case TimerCommand::Type::release:
+        case TimerCommand::Type::createGroup:
+        case TimerCommand::Type::groupOperation:
+            break;
+        }
+    }
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::TimerDeleter::operator()(Timer* timer) const
+{
+    auto manager = timer->m_manager;
+    if (manager and manager->isForeignThread())
+    {
+        TimerCommand command;
+        command.type = TimerCommand::Type::destroy;
+        command.rawTimer = timer;
+        command.pool = pool;
+        manager->m_deadTimers.fetch_add(1, std::memory_order_relaxed);
+        manager->postCommand(std::move(command));
+        return;
+    }
+    destroyTimer(timer, pool);
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::releaseOnOwnerThread(std::shared_ptr<Timer> timer)
+{
+    // see TimerDeleter, the last reference must not delete the timer on another thread
+    auto manager = timer->m_manager;
+    if (manager and manager->isForeignThread())
+    {
+        TimerCommand command;
+        command.type = TimerCommand::Type::release;
+        command.reference = std::move(timer);
+        manager->postCommand(std::move(command));
+    }
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::destroyTimer(Timer* timer, TimerPool* pool)
+{
+    if (pool)
+    {
+        timer->~Timer();
+        pool->deallocate(timer, sizeof(Timer));
+    }
+    else
+    {
+        delete timer;
+    }
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::fastForward(Duration duration)
+{
+    // this is not allowed when polling is active
+    if (m_timeBase.isPolling())
+    {
+        return;
+    }
+    m_timeBase.fastForward(duration);
+    poll();
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::pause()
+{
+    // this is not allowed when polling is active
+    if (m_timeBase.isPolling())
+    {
+        return;
+    }
+    m_timeBase.pause();
+    notifyExpiryObserver();
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::resume()
+{
+    // this is not allowed when polling is active
+    if (m_timeBase.isPolling())
+    {
+        return;
+    }
+    m_timeBase.resume();
+    notifyExpiryObserver();
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::rescale(double rate)
+{
+    // this is not allowed when polling is active
+    if (m_timeBase.isPolling())
+    {
+        return;
+    }
+    m_timeBase.rescale(rate);
+    notifyExpiryObserver();
+}
+
+template <typename ClockPolicy, typename Duration>
+Duration BasicTimerManager<ClockPolicy, Duration>::now() const
+{
+    return m_timeBase.now();
+}
+
+template <typename ClockPolicy, typename Duration>
+BasicTimerManager<ClockPolicy, Duration>::Simulation::Simulation(BasicTimerManager& manager)
+: m_manager(manager)
+, m_wasPaused(manager.m_timeBase.isPaused())
+, m_wasSimulating(manager.m_simulating)
+{
+    m_manager.m_timeBase.pause();
+    m_manager.m_simulating = true;
+}
+
+template <typename ClockPolicy, typename Duration>
+BasicTimerManager<ClockPolicy, Duration>::Simulation::~Simulation()
+{
+    if (m_wasSimulating)
+    {
+        return;
+    }
+    if (not m_wasPaused)
+    {
+        m_manager.m_timeBase.resume();
+    }
+    m_manager.m_simulating = false;
+    m_manager.notifyExpiryObserver();
+}
+
+template <typename ClockPolicy, typename Duration>
+bool BasicTimerManager<ClockPolicy, Duration>::nextExpireTime(Duration& expireTime)
+{
+    processCommands();
+    for (auto& deadlines : m_deadlines)
+    {
+        // restarted to a later deadline, see poll
+        while (not deadlines.empty() and deadlines.top()->m_deadline != deadlines.top()->m_expireTime)
+        {
+            auto earliest = deadlines.top();
+            earliest->m_expireTime = earliest->m_deadline;
+            deadlines.update(*earliest);
+        }
+    }
+    auto earliest = earliestTimer();
+    if (earliest)
+    {
+        expireTime = earliest->m_expireTime;
+    }
+    return earliest != nullptr;
+}
+
+template <typename ClockPolicy, typename Duration>
+BasicTimerHeap<BasicTimer<ClockPolicy, Duration>>& BasicTimerManager<ClockPolicy, Duration>::deadlines(const Timer& timer)
+{
+    return m_deadlines[static_cast<std::size_t>(timer.m_priority)];
+}
+
+template <typename ClockPolicy, typename Duration>
+BasicTimer<ClockPolicy, Duration>* BasicTimerManager<ClockPolicy, Duration>::earliestTimer() const
+{
+    Timer* earliest = nullptr;
+    for (const auto& deadlines : m_deadlines)
+    {
+        if (deadlines.empty())
+        {
+            continue;
+        }
+        // same order as within a heap
+        auto top = deadlines.top();
+        if (not earliest or top->m_expireTime < earliest->m_expireTime
+            or (top->m_expireTime == earliest->m_expireTime and top->m_sequence < earliest->m_sequence))
+        {
+            earliest = top;
+        }
+    }
+    return earliest;
+}
+
+template <typename ClockPolicy, typename Duration>
+BasicTimer<ClockPolicy, Duration>* BasicTimerManager<ClockPolicy, Duration>::dueTop(BasicTimerHeap<Timer>& deadlines,
+                                                                                    Duration currentTime)
+{
+    while (not deadlines.empty() and currentTime >= deadlines.top()->m_expireTime)
+    {
+        // restarted to a later deadline, it moves now instead of expiring
+        auto earliest = deadlines.top();
+        if (earliest->m_deadline == earliest->m_expireTime)
+        {
+            return earliest;
+        }
+        earliest->m_expireTime = earliest->m_deadline;
+        deadlines.update(*earliest);
+    }
+    return nullptr;
+}
+
+template <typename ClockPolicy, typename Duration>
+std::size_t BasicTimerManager<ClockPolicy, Duration>::nextDuePriority(Duration currentTime)
+{
+    auto priority = timerPriorityCount;
+    for (std::size_t candidate = 0; candidate < timerPriorityCount; ++candidate)
+    {
+        if (not dueTop(m_deadlines[candidate], currentTime))
+        {
+            continue;
+        }
+        if (priority == timerPriorityCount)
+        {
+            priority = candidate;
+        }
+        else if (m_passedOver[candidate] >= m_starvationLimit)
+        {
+            return candidate;
+        }
+    }
+    return priority;
+}
+
+template <typename ClockPolicy, typename Duration>
+Duration BasicTimerManager<ClockPolicy, Duration>::callbackTime(const Timer& timer)
+{
+    m_latestCallbackTime = std::max(m_latestCallbackTime, timer.m_expireTime);
+    return m_latestCallbackTime;
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::passOver(std::size_t priority, Duration currentTime)
+{
+    for (std::size_t other = 0; other < timerPriorityCount; ++other)
+    {
+        // a class waits only while it has a due timer
+        const auto waiting = other != priority and dueTop(m_deadlines[other], currentTime);
+        m_passedOver[other] = waiting ? m_passedOver[other] + 1 : 0;
+    }
+}
+
+template <typename ClockPolicy, typename Duration>
+bool BasicTimerManager<ClockPolicy, Duration>::step()
+{
+    if (m_timeBase.isPolling())
+    {
+        return false;
+    }
+    Simulation simulation(*this);
+    Duration expireTime;
+    if (not nextExpireTime(expireTime))
+    {
+        return false;
+    }
+    const auto currentTime = m_timeBase.now();
+    if (expireTime > currentTime)
+    {
+        m_timeBase.fastForward(expireTime - currentTime);
+    }
+    poll();
+    return true;
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::runUntil(Duration time)
+{
+    if (m_timeBase.isPolling())
+    {
+        return;
+    }
+    Simulation simulation(*this);
+    Duration expireTime;
+    while (nextExpireTime(expireTime) and expireTime <= time)
+    {
+        const auto currentTime = m_timeBase.now();
+        if (expireTime > currentTime)
+        {
+            m_timeBase.fastForward(expireTime - currentTime);
+        }
+        poll();
+    }
+    const auto currentTime = m_timeBase.now();
+    if (time > currentTime)
+    {
+        m_timeBase.fastForward(time - currentTime);
+    }
+}
+
+template <typename ClockPolicy, typename Duration>
+std::size_t BasicTimerManager<ClockPolicy, Duration>::runUntilIdle()
+{
+    if (m_timeBase.isPolling())
+    {
+        return 0;
+    }
+    Simulation simulation(*this);
+    std::size_t steps = 0;
+    while (step())
+    {
+        ++steps;
+    }
+    return steps;
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::setExpiryTrace(ExpiryTrace trace)
+{
+    m_expiryTrace = trace;
+}
+
+template <typename ClockPolicy, typename Duration>
+Duration BasicTimerManager<ClockPolicy, Duration>::timeUntilNextExpiry() const
+{
+    auto earliest = earliestTimer();
+    if (not earliest)
+    {
+        return this->noExpiry();
+    }
+    return std::max(Duration::zero(), earliest->m_expireTime - m_timeBase.now());
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::waitAndPoll(Duration maxWait)
+{
+    // waiting inside a callback would only delay the running poll
+    if (m_timeBase.isPolling())
+    {
+        return;
+    }
+    // while paused the steady clock does not move our timers, only fast forward does
+    // commands posted after prepareWait notify us, earlier ones are processed before calculating the timeout
+    m_wakeupSignal.prepareWait();
+    processCommands();
+    auto timeout = m_timeBase.isPaused() ? maxWait : std::min(maxWait, m_timeBase.toClockDuration(timeUntilNextExpiry()));
+    m_wakeupSignal.waitFor(timeout);
+    poll();
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::wakeup()
+{
+    m_wakeupSignal.notify();
+}
+
+template <typename ClockPolicy, typename Duration>
+void BasicTimerManager<ClockPolicy, Duration>::poll()
+{
+    pollBounded(std::numeric_limits<std::size_t>::max(), std::chrono::nanoseconds::max());
+}
+
+template <typename ClockPolicy, typename Duration>
+typename BasicTimerManager<ClockPolicy, Duration>::PollResult BasicTimerManager<ClockPolicy, Duration>::poll(
+    std::size_t maxExpirations)
+{
+    return pollBounded(maxExpirations, std::chrono::nanoseconds::max());
+}
+
+template <typename ClockPolicy, typename Duration>
+typename BasicTimerManager<ClockPolicy, Duration>::PollResult BasicTimerManager<ClockPolicy, Duration>::pollFor(
+    std::chrono::nanoseconds budget)
+{
+    return pollBounded(std::numeric_limits<std::size_t>::max(), budget);
+}
+
+template <typename ClockPolicy, typename Duration>
+typename BasicTimerManager<ClockPolicy, Duration>::PollResult BasicTimerManager<ClockPolicy, Duration>::pollBounded(
+    std::size_t maxExpirations, std::chrono::nanoseconds budget)
+{
+    PollResult result;
+    // only one poll at the same time allowed
+    if (m_timeBase.isPolling())
+    {
+        return result;
+    }
+    // operations of other threads are done first, timers they start count from now
+    processCommands();
+    const auto currentTime = m_timeBase.now();
+    auto metrics = m_metrics.get();
+    const auto measureDurations = metrics and m_measureDurations;
+    std::chrono::steady_clock::time_point pollBegin;
+    std::chrono::steady_clock::time_point callbackBegin;
+    if (measureDurations)
+    {
+        pollBegin = callbackBegin = std::chrono::steady_clock::now();
+    }
+    const auto budgeted = budget != std::chrono::nanoseconds::max();
+    std::chrono::steady_clock::time_point budgetEnd;
+    if (budgeted)
+    {
+        budgetEnd = std::chrono::steady_clock::now() + budget;
+    }
+    std::size_t expirations = 0;
+    auto lastDeadline = Duration::min();
+    // this flag allows time duration correct timer behavior when timers are created during poll in callback
+    // we modify the current time to the time of currently expired timer. This means when a callback creates does operations on timers we
+    // we have the current timers expire time as reference.
+    m_timeBase.beginPoll();
+    m_latestCallbackTime = Duration::min();
+
+    // Process earliest expired timer of the highest due class, then determine next expired timer again.
+    // Timers (re)started in callbacks are part of the deadline index immediately.
+    // the end of one expiry is the begin of the next, one clock read per expiry. Dispatched callbacks are not measured
+    auto endExpiry = [&](bool calledBack) {
+        if (measureDurations)
+        {
+            const auto callbackEnd = std::chrono::steady_clock::now();
+            if (calledBack)
+            {
+                metrics->callbackDuration.record(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(callbackEnd - callbackBegin).count());
+            }
+            callbackBegin = callbackEnd;
+        }
+    };
+    auto stoppedAtBound = false;
+    for (auto priority = nextDuePriority(currentTime); priority != timerPriorityCount; priority = nextDuePriority(currentTime))
+    {
+        // stop early, the remaining due timers are the first ones of the next poll
+        if (expirations == maxExpirations or (budgeted and expirations > 0 and std::chrono::steady_clock::now() >= budgetEnd))
+        {
+            stoppedAtBound = true;
+            break;
+        }
+        passOver(priority, currentTime);
+        auto earliest = m_deadlines[priority].top();
+        ++expirations;
+        if (metrics)
+        {
+            if (earliest->m_expireTime != lastDeadline)
+            {
+                lastDeadline = earliest->m_expireTime;
+                metrics->firedDeadlines.store(metrics->firedDeadlines.load(std::memory_order_relaxed) + 1,
+                                              std::memory_order_relaxed);
+            }
+            metrics->lateness.record(std::chrono::duration_cast<std::chrono::nanoseconds>(currentTime - earliest->m_expireTime).count());
+        }
+        if (m_expiryTrace)
+        {
+            m_expiryTrace(earliest->m_expireTime, *earliest);
+        }
+        if (earliest->m_embedded)
+        {
+            expireEmbeddedTimer(*earliest);
+            endExpiry(true);
+            continue;
+        }
+        if (earliest->m_handle)
+        {
+            expireHandleTimer(*earliest, currentTime);
+            endExpiry(true);
+            continue;
+        }
+        // keep timer alive during callback, even when the callback drops the last reference
+        auto timer = earliest->shared_from_this();
+        m_timeBase.setPollTimeStamp(callbackTime(*timer));
+        timer->stop();
+        // missed periods are known before the callback runs, the next period counts from restartTime
+        auto restartTime = timer->m_expireTime;
+        if (not timer->m_isSingleShot)
+        {
+            restartTime = tickRestartTime(timer->m_missedTickPolicy, timer->m_expireTime, currentTime, timer->m_duration,
+                                          timer->m_missedTicks);
+        }
+        if (m_callbackExecutor)
+        {
+            if (not timer->m_isSingleShot)
+            {
+                m_timeBase.setPollTimeStamp(restartTime);
+                timer->start(timer->m_duration, timer->m_slack);
+            }
+            m_callbackExecutor(timer->m_orderingKey, [timer]() mutable {
+                timer->invokeTimeoutCallback();
+                releaseOnOwnerThread(std::move(timer));
+            });
+            endExpiry(false);
+            continue;
+        }
+        timer->invokeTimeoutCallback();
+        if (not timer->m_isSingleShot)
+        {
+            m_timeBase.setPollTimeStamp(restartTime);
+            timer->start(timer->m_duration, timer->m_slack);
+        }
+        endExpiry(true);
+    }
+    m_timeBase.endPoll();
+    result.expired = expirations;
+    // a poll running to completion leaves nothing due behind
+    if (stoppedAtBound)
+    {
+        for (const auto& deadlines : m_deadlines)
+        {
+            // timers moved to a later deadline by restart are not due
+            deadlines.visitExpiringUntil(currentTime, [&result, currentTime](const Timer& timer) {
+                result.overdue += currentTime >= timer.m_deadline ? 1 : 0;
+            });
+        }
+    }
+    if (metrics)
+    {
+        metrics->expirationsPerPoll.record(expirations);
+        if (measureDurations)
+        {
+            metrics->pollDuration.record(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - pollBegin).count());
+        }
+        metrics->liveTimers.store(m_liveTimers, std::memory_order_relaxed);
+        std::size_t armedTimers = 0;
+        for (const auto& deadlines : m_deadlines)
+        {
+            armedTimers += deadlines.size();
+        }
+        metrics->armedTimers.store(armedTimers, std::memory_order_relaxed);
+        metrics->deadTimers.store(m_deadTimers.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    notifyExpiryObserver();
+    return result;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/** Histogram with power of two buckets: bucket 0 counts zeros, bucket i counts values in [2^(i-1), 2^i).
+ * Written by a single thread, readable lock-free from any thread. Reads are not a consistent snapshot
+ * while the writer is active. */
+class LogHistogram
+{
+public:
+    static constexpr std::size_t bucketCount = 65;
+
+    /** single writer only */
+    void record(std::uint64_t value)
+    {
+        increment(m_buckets[bucketIndex(value)]);
+        increment(m_count);
+        m_sum.store(m_sum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        if (value > m_max.load(std::memory_order_relaxed))
+        {
+            m_max.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    std::uint64_t count() const
+    {
+        return m_count.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t sum() const
+    {
+        return m_sum.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t max() const
+    {
+        return m_max.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t bucket(std::size_t index) const
+    {
+        return m_buckets[index].load(std::memory_order_relaxed);
+    }
+
+    /** largest value counted by bucket index */
+    static std::uint64_t bucketUpperBound(std::size_t index)
+    {
+        return index == 0 ? 0 : index == 64 ? UINT64_MAX : (std::uint64_t(1) << index) - 1;
+    }
+
+    /** upper bound of the bucket containing the given fraction (0..1) of the values, 0 when empty */
+    std::uint64_t percentile(double fraction) const
+    {
+        const auto total = count();
+        if (total == 0)
+        {
+            return 0;
+        }
+        const auto rank = std::uint64_t(fraction * (total - 1)) + 1;
+        std::uint64_t seen = 0;
+        for (std::size_t index = 0; index < bucketCount; ++index)
+        {
+            seen += bucket(index);
+            if (seen >= rank)
+            {
+                return bucketUpperBound(index);
+            }
+        }
+        return max();
+    }
+
+    static std::size_t bucketIndex(std::uint64_t value)
+    {
+        return value == 0 ? 0 : 64 - std::size_t(__builtin_clzll(value));
+    }
+
+private:
+    // no read-modify-write needed for a single writer, plain loads and stores are cheaper
+    static void increment(std::atomic<std::uint64_t>& counter)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<std::uint64_t>, bucketCount> m_buckets{};
+    std::atomic<std::uint64_t> m_count{0};
+    std::atomic<std::uint64_t> m_sum{0};
+    std::atomic<std::uint64_t> m_max{0};
+};
+
+/** Runtime metrics of a timer manager, see BasicTimerManager::enableMetrics. Durations are in nanoseconds.
+ * Written by the polling thread, readable lock-free from any thread. */
+struct TimerMetrics
+{
+    /** poll time minus expire time of every expired timer */
+    LogHistogram lateness;
+    /** execution time of every callback called by poll including the restart of its timer, only when measured.
+     * Callbacks handed to a callback executor are not measured */
+    LogHistogram callbackDuration;
+    LogHistogram expirationsPerPoll;
+    LogHistogram pollDuration;
+    /** Distinct expire times fired. Each one is a wakeup of waitAndPoll, timers coalesced by slack share one.
+     * Compare with expirationsPerPoll.sum() */
+    std::atomic<std::uint64_t> firedDeadlines{0};
+
+    // as of the end of the last poll
+    std::atomic<std::uint64_t> liveTimers{0};  // created and not yet deleted
+    std::atomic<std::uint64_t> armedTimers{0}; // running
+    std::atomic<std::uint64_t> deadTimers{0};  // released on other threads, waiting for deletion by the owner thread
+};
@@ -0,0 +1,91 @@
+#include "TimerPool.hpp"
+
+#include <algorithm>
+#include <new>
+
+constexpr std::size_t TimerPool::alignment;
+constexpr std::size_t TimerPool::firstSlabBlocks;
+constexpr std::size_t TimerPool::maximumSlabBlocks;
+
+TimerPool::~TimerPool()
+{
+    for (auto slab : m_slabs)
+    {
+        ::operator delete(slab);
+    }
+}
+
+void* TimerPool::allocate(std::size_t bytes)
+{
+    auto& blocks = sizeClass(bytes);
+    if (not blocks.freeBlocks)
+    {
+        grow(blocks);
+    }
+    auto block = blocks.freeBlocks;
+    blocks.freeBlocks = block->next;
+    ++m_blocksInUse;
+    return block;
+}
+
+void TimerPool::deallocate(void* block, std::size_t bytes)
+{
+    auto& blocks = sizeClass(bytes);
+    auto freeBlock = static_cast<FreeBlock*>(block);
+    freeBlock->next = blocks.freeBlocks;
+    blocks.freeBlocks = freeBlock;
+    --m_blocksInUse;
+    if (m_released and m_blocksInUse == 0)
+    {
+        delete this;
+    }
+}
+
+void TimerPool::release()
+{
+    m_released = true;
+    if (m_blocksInUse == 0)
+    {
+        delete this;
+    }
+}
+
+std::size_t TimerPool::blocksInUse() const
+{
+    return m_blocksInUse;
+}
+
+std::size_t TimerPool::reservedBytes() const
+{
+    return m_reservedBytes;
+}
+
+TimerPool::SizeClass& TimerPool::sizeClass(std::size_t bytes)
+{
+    const auto blockSize = (std::max(bytes, sizeof(FreeBlock)) + alignment - 1) / alignment * alignment;
+    for (auto& existing : m_sizeClasses)
+    {
+        if (existing.blockSize == blockSize)
+        {
+            return existing;
+        }
+    }
+    m_sizeClasses.push_back({blockSize, nullptr, firstSlabBlocks});
+    return m_sizeClasses.back();
+}
+
+void TimerPool::grow(SizeClass& blocks)
+{
+    // slabs double in size up to a limit, so small managers stay small and large ones need few slabs
+    const auto count = blocks.nextSlabBlocks;
+    blocks.nextSlabBlocks = std::min(count * 2, maximumSlabBlocks);
+    auto slab = static_cast<char*>(::operator new(count * blocks.blockSize));
+    m_slabs.push_back(slab);
+    m_reservedBytes += count * blocks.blockSize;
+    for (std::size_t index = count; index > 0; --index)
+    {
+        auto block = reinterpret_cast<FreeBlock*>(slab + (index - 1) * blocks.blockSize);
+        block->next = blocks.freeBlocks;
+        blocks.freeBlocks = block;
+    }
+}
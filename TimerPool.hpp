@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/** Slab allocator for the timers of one TimerManager. Blocks are carved from slabs and recycled through
+ * per size free lists, so creating a timer allocates nothing once the pool has grown to the peak timer count.
+ * Timers may outlive their manager: the manager calls release() instead of deleting the pool, which deletes
+ * itself as soon as the last block came back. Not thread-safe. */
+class TimerPool
+{
+public:
+    TimerPool() = default;
+
+    void* allocate(std::size_t bytes);
+
+    void deallocate(void* block, std::size_t bytes);
+
+    /** owner is done with the pool, it is deleted when no block is in use anymore */
+    void release();
+
+    std::size_t blocksInUse() const;
+
+    /** bytes reserved by slabs */
+    std::size_t reservedBytes() const;
+
+private:
+    static constexpr std::size_t alignment = alignof(std::max_align_t);
+    static constexpr std::size_t firstSlabBlocks = 16;
+    static constexpr std::size_t maximumSlabBlocks = 1024;
+
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    struct SizeClass
+    {
+        std::size_t blockSize;
+        FreeBlock* freeBlocks;
+        std::size_t nextSlabBlocks;
+    };
+
+    ~TimerPool();
+    TimerPool(const TimerPool&) = delete;
+    TimerPool& operator=(const TimerPool&) = delete;
+
+    SizeClass& sizeClass(std::size_t bytes);
+    void grow(SizeClass& sizeClass);
+
+    std::vector<SizeClass> m_sizeClasses; // a timer needs one or two sizes, so a linear search is fine
+    std::vector<void*> m_slabs;
+    std::size_t m_reservedBytes = 0;
+    std::size_t m_blocksInUse = 0;
+    bool m_released = false;
+};
+
+/** Standard allocator interface on top of TimerPool, e.g. for std::allocate_shared */
+template <typename T>
+class TimerPoolAllocator
+{
+public:
+    using value_type = T;
+
+    explicit TimerPoolAllocator(TimerPool& pool)
+    : m_pool(&pool)
+    {}
+
+    template <typename U>
+    TimerPoolAllocator(const TimerPoolAllocator<U>& other)
+    : m_pool(other.m_pool)
+    {}
+
+    T* allocate(std::size_t count)
+    {
+        return static_cast<T*>(m_pool->allocate(count * sizeof(T)));
+    }
+
+    void deallocate(T* block, std::size_t count)
+    {
+        m_pool->deallocate(block, count * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const TimerPoolAllocator<U>& other) const
+    {
+        return m_pool == other.m_pool;
+    }
+
+    template <typename U>
+    bool operator!=(const TimerPoolAllocator<U>& other) const
+    {
+        return m_pool != other.m_pool;
+    }
+
+private:
+    template <typename U>
+    friend class TimerPoolAllocator;
+
+    TimerPool* m_pool;
+};
@@ -1,29 +1,228 @@
+#include "ScanTimerManager.hpp"
+#include "ShardedTimerManager.hpp"
+#include "StaticTimerManager.hpp"
+#include "ThreadPoolExecutor.hpp"
+#include "TimerCoroutines.hpp"
+#include "TimerFdDriver.hpp"
 #include "TimerManager.hpp"
+#include "TimingWheelTimerManager.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <cstdlib>
+#include <future>
 #include <gmock/gmock.h>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <new>
+#include <string>
 #include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <poll.h>
+#endif
 
 using namespace ::testing;
 
-class TimerTest : public Test
+namespace {
+
+thread_local std::size_t allocationCount = 0;
+
+void* countedAllocate(std::size_t size, std::size_t alignment) noexcept
+{
+    ++allocationCount;
+    size = size ? size : 1;
+#ifdef __cpp_aligned_new
+    if (alignment > alignof(std::max_align_t))
+    {
+        // aligned_alloc wants a multiple of the alignment
+        return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    }
+#else
+    static_cast<void>(alignment);
+#endif
+    return std::malloc(size);
+}
+
+void* countedAllocateOrThrow(std::size_t size, std::size_t alignment)
+{
+    if (auto block = countedAllocate(size, alignment))
+    {
+        return block;
+    }
+    throw std::bad_alloc();
+}
+
+} // namespace
+
+// Counts allocations of the test thread, see AllocationCounter. Every replaceable form is replaced, so allocation
+// and deallocation always match. Not inlined: the compiler would see free() on memory of operator new otherwise.
+#define TEST_ALLOCATOR __attribute__((noinline))
+
+TEST_ALLOCATOR void* operator new(std::size_t size)
+{
+    return countedAllocateOrThrow(size, alignof(std::max_align_t));
+}
+
+TEST_ALLOCATOR void* operator new[](std::size_t size)
+{
+    return countedAllocateOrThrow(size, alignof(std::max_align_t));
+}
+
+TEST_ALLOCATOR void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAllocate(size, alignof(std::max_align_t));
+}
+
+TEST_ALLOCATOR void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAllocate(size, alignof(std::max_align_t));
+}
+
+TEST_ALLOCATOR void operator delete(void* block) noexcept
+{
+    std::free(block);
+}
+
+TEST_ALLOCATOR void operator delete[](void* block) noexcept
+{
+    std::free(block);
+}
+
+TEST_ALLOCATOR void operator delete(void* block, std::size_t) noexcept
+{
+    std::free(block);
+}
+
+TEST_ALLOCATOR void operator delete[](void* block, std::size_t) noexcept
+{
+    std::free(block);
+}
+
+TEST_ALLOCATOR void operator delete(void* block, const std::nothrow_t&) noexcept
+{
+    std::free(block);
+}
+
+TEST_ALLOCATOR void operator delete[](void* block, const std::nothrow_t&) noexcept
+{
+    std::free(block);
+}
+
+#ifdef __cpp_aligned_new
+TEST_ALLOCATOR void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    return countedAllocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+
+TEST_ALLOCATOR void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return countedAllocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+
+TEST_ALLOCATOR void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return countedAllocate(size, static_cast<std::size_t>(alignment));
+}
+
+TEST_ALLOCATOR void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return countedAllocate(size, static_cast<std::size_t>(alignment));
+}
+
+TEST_ALLOCATOR void operator delete(void* block, std::align_val_t) noexcept
+{
+    std::free(block);
+}
+
+TEST_ALLOCATOR void operator delete[](void* block, std::align_val_t) noexcept
+{
+    std::free(block);
+}
+
+TEST_ALLOCATOR void operator delete(void* block, std::size_t, std::align_val_t) noexcept
+{
+    std::free(block);
+}
+
+TEST_ALLOCATOR void operator delete[](void* block, std::size_t, std::align_val_t) noexcept
+{
+    std::free(block);
+}
+
+TEST_ALLOCATOR void operator delete(void* block, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    std::free(block);
+}
+
+TEST_ALLOCATOR void operator delete[](void* block, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    std::free(block);
+}
+#endif
+
+#undef TEST_ALLOCATOR
+
+class AllocationCounter
+{
+public:
+    std::size_t allocations() const
+    {
+        return allocationCount - m_allocationsAtStart;
+    }
+
+private:
+    const std::size_t m_allocationsAtStart = allocationCount;
+};
+
+using ManagerFactory = std::function<std::shared_ptr<ITimerManager>(TimerManager::SteadyTickCallbackType)>;
+
+class MockClockTest : public Test
 {
 public:
-    TimerTest()
+    MockClockTest()
     {
         EXPECT_CALL(m_getTimeCallback, Call()).WillRepeatedly(ReturnPointee(&m_currentTime));
     }
 
+    MockFunction<std::chrono::milliseconds(void)> m_getTimeCallback;
+    std::chrono::milliseconds m_currentTime = 0ms;
+};
+
+/** behavior every ITimerManager implementation has to provide */
+class TimerTest : public MockClockTest, public WithParamInterface<ManagerFactory>
+{
+public:
     std::shared_ptr<ITimerManager> createUUT()
     {
+        return GetParam()(m_getTimeCallback.AsStdFunction());
+    }
+};
+
+template <typename Manager>
+std::shared_ptr<ITimerManager> createManager(TimerManager::SteadyTickCallbackType steadyTickProvider)
+{
+    return std::make_shared<Manager>(steadyTickProvider);
+}
+
+INSTANTIATE_TEST_SUITE_P(TimerManager, TimerTest, Values(createManager<TimerManager>));
+INSTANTIATE_TEST_SUITE_P(TimingWheelTimerManager, TimerTest, Values(createManager<TimingWheelTimerManager>));
+INSTANTIATE_TEST_SUITE_P(ScanTimerManager, TimerTest, Values(createManager<ScanTimerManager>));
 
+/** behavior specific to TimerManager */
+class TimerManagerTest : public MockClockTest
+{
+public:
+    std::shared_ptr<TimerManager> createUUT()
+    {
         return std::make_shared<TimerManager>(m_getTimeCallback.AsStdFunction());
     }
-
-    MockFunction<std::chrono::milliseconds(void)> m_getTimeCallback;
-    std::chrono::milliseconds m_currentTime = 0ms;
 };
 
-TEST_F(TimerTest, simpleExpireTest)
+TEST_P(TimerTest, simpleExpireTest)
 {
     StrictMock<MockFunction<void(void)>> timerCallback;
     auto uut = createUUT();
@@ -41,7 +240,7 @@ TEST_F(TimerTest, simpleExpireTest)
     uut->poll();
 }
 
-TEST_F(TimerTest, MultipleTimersExpireInRightOrderTest)
+TEST_P(TimerTest, MultipleTimersExpireInRightOrderTest)
 {
     StrictMock<MockFunction<void(void)>> timerCallback1;
     StrictMock<MockFunction<void(void)>> timerCallback2;
@@ -70,7 +269,7 @@ TEST_F(TimerTest, MultipleTimersExpireInRightOrderTest)
     uut->poll();
 }
 
-TEST_F(TimerTest, MultipleTimersExpireInRightOrderFastForwardTest)
+TEST_P(TimerTest, MultipleTimersExpireInRightOrderFastForwardTest)
 {
     StrictMock<MockFunction<void(void)>> timerCallback1;
     StrictMock<MockFunction<void(void)>> timerCallback2;
@@ -128,165 +327,995 @@ TEST_F(TimerTest, MultipleTimersExpireInRightOrderFastForwardTest)
     EXPECT_FALSE(timer1->isRunning());
 }
 
-TEST_F(TimerTest, PauseAndFastForwardTest)
+TEST_P(TimerTest, LongTimersExpireExactlyTest)
 {
-    StrictMock<MockFunction<void(void)>> timerCallback1;
-
     auto uut = createUUT();
 
-    auto timer1 = uut->createSingleShotTimer();
-    timer1->setTimeoutCallback(timerCallback1.AsStdFunction());
-    EXPECT_FALSE(timer1->isRunning());
-    timer1->start(1100ms);
-
-    uut->pause();
-
-    uut->fastForward(1000ms);
-    m_currentTime += 1000ms; // this should not raise timer event since we are in paused mode
-    uut->poll();
-    EXPECT_EQ(100ms, timer1->getRemainingMilliseconds());
-    EXPECT_CALL(timerCallback1, Call());
-    uut->fastForward(100ms);
-    EXPECT_EQ(0ms, timer1->getRemainingMilliseconds());
+    // durations around the boundaries of timing wheel levels and beyond
+    const std::vector<std::chrono::milliseconds> durations = {
+        1ms, 63ms, 64ms, 65ms, 4095ms, 4096ms, 4097ms, 262145ms, 1h, 1000h, 24000h};
+    std::vector<std::shared_ptr<ITimer>> timers;
+    std::vector<StrictMock<MockFunction<void(void)>>> timerCallbacks(durations.size());
 
-    EXPECT_CALL(timerCallback1, Call()).Times(0);
-    uut->resume();
-    timer1->start(500ms);
-    m_currentTime += 499ms;
-    uut->poll();
-    EXPECT_EQ(1ms, timer1->getRemainingMilliseconds());
+    for (std::size_t index = 0; index < durations.size(); ++index)
+    {
+        timers.push_back(uut->createSingleShotTimer());
+        timers.back()->setTimeoutCallback(timerCallbacks[index].AsStdFunction());
+        timers.back()->start(durations[index]);
+    }
 
-    m_currentTime += 1ms;
-    EXPECT_CALL(timerCallback1, Call());
-    uut->poll();
-    EXPECT_EQ(0ms, timer1->getRemainingMilliseconds());
+    auto elapsed = 0ms;
+    for (std::size_t index = 0; index < durations.size(); ++index)
+    {
+        uut->fastForward(durations[index] - 1ms - elapsed);
+        EXPECT_EQ(1ms, timers[index]->getRemainingMilliseconds());
+        EXPECT_CALL(timerCallbacks[index], Call());
+        uut->fastForward(1ms);
+        Mock::VerifyAndClearExpectations(&timerCallbacks[index]);
+        elapsed = durations[index];
+    }
 }
 
-TEST_F(TimerTest, CheckTimeCorrectnessDuringManipulationsTest)
+TEST_F(TimerManagerTest, EqualExpireTimesExpireInCreationOrderTest)
 {
     StrictMock<MockFunction<void(void)>> timerCallback1;
-
+    StrictMock<MockFunction<void(void)>> timerCallback2;
+    StrictMock<MockFunction<void(void)>> timerCallback3;
     auto uut = createUUT();
 
-    auto timer1 = uut->createTickTimer();
+    auto timer1 = uut->createSingleShotTimer();
     timer1->setTimeoutCallback(timerCallback1.AsStdFunction());
+    auto timer2 = uut->createSingleShotTimer();
+    timer2->setTimeoutCallback(timerCallback2.AsStdFunction());
+    auto timer3 = uut->createSingleShotTimer();
+    timer3->setTimeoutCallback(timerCallback3.AsStdFunction());
 
-    timer1->start(500ms);
-
-    EXPECT_EQ(500ms, timer1->getRemainingMilliseconds());
-    m_currentTime += 100ms;
-    EXPECT_EQ(400ms, timer1->getRemainingMilliseconds());
-    uut->fastForward(2ms);
-    uut->pause();
-    EXPECT_EQ(398ms, timer1->getRemainingMilliseconds());
+    timer3->start(300ms);
+    timer2->start(300ms);
+    timer1->start(300ms);
 
-    uut->fastForward(2ms);
-    EXPECT_EQ(396ms, timer1->getRemainingMilliseconds());
-    m_currentTime += 1ms;
-    EXPECT_EQ(396ms, timer1->getRemainingMilliseconds());
+    Sequence seq;
+    EXPECT_CALL(timerCallback1, Call()).InSequence(seq);
+    EXPECT_CALL(timerCallback2, Call()).InSequence(seq);
+    EXPECT_CALL(timerCallback3, Call()).InSequence(seq);
 
-    uut->resume();
+    uut->fastForward(300ms);
+}
 
-    m_currentTime += 395ms;
-    uut->poll();
-    EXPECT_EQ(1ms, timer1->getRemainingMilliseconds());
+TEST_F(TimerManagerTest, CreateAndDeleteTimersWithoutAllocationInSteadyStateTest)
+{
+    // the mocked clock allocates itself
+    auto uut = std::make_shared<TimerManager>([]() { return 0ms; });
+    std::vector<std::shared_ptr<ITimer>> timers;
+    timers.reserve(100);
+
+    auto createAndDelete = [&]() {
+        for (int index = 0; index < 100; ++index)
+        {
+            timers.push_back(index % 2 ? uut->createTickTimer() : uut->createSingleShotTimer());
+            timers.back()->start(1s);
+        }
+        timers.clear();
+    };
+    createAndDelete();
+
+    AllocationCounter counter;
+    createAndDelete();
+    EXPECT_EQ(0u, counter.allocations());
+}
 
-    EXPECT_CALL(timerCallback1, Call());
+TEST_F(TimerManagerTest, RearmWithNewLambdaWithoutAllocationTest)
+{
+    auto uut = std::make_shared<TimerManager>([]() { return 0ms; });
+    auto timer = uut->createSingleShotTimer();
+    auto state = std::make_shared<int>(0);
+    int calls = 0;
+
+    auto rearm = [&](int step) {
+        auto callback = [state, &calls, step]() { calls += step; };
+        static_assert(InlineCallback::fits<decltype(callback)>(), "small lambdas are stored inline");
+        timer->setTimeoutCallback(callback);
+        timer->start(1ms);
+        uut->fastForward(1ms);
+    };
+    rearm(1);
+
+    AllocationCounter counter;
+    for (int step = 0; step < 100; ++step)
+    {
+        rearm(1);
+    }
+    EXPECT_EQ(0u, counter.allocations());
+    EXPECT_EQ(101, calls);
+
+    auto large = [state, &calls, a = std::array<char, 64>()]() { calls += a.size(); };
+    static_assert(not InlineCallback::fits<decltype(large)>(), "large lambdas are not stored inline");
+    // they do not compile on their own, the heap is opted in with an explicit std::function
+    timer->setTimeoutCallback(std::function<void()>(large));
+    timer->start(1ms);
     uut->fastForward(1ms);
+    EXPECT_EQ(165, calls);
 }
 
-TEST_F(TimerTest, CycleTimerTest)
+TEST_F(TimerManagerTest, MetricsTest)
 {
-    StrictMock<MockFunction<void(void)>> timerCallback1;
-
+    NiceMock<MockFunction<void(void)>> timerCallback;
     auto uut = createUUT();
+    auto metrics = uut->enableMetrics();
 
-    auto timer1 = uut->createTickTimer();
-    timer1->setTimeoutCallback(timerCallback1.AsStdFunction());
-    EXPECT_FALSE(timer1->isRunning());
-    EXPECT_FALSE(timer1->expired());
-    timer1->start(250ms);
+    auto timer1 = uut->createSingleShotTimer();
+    timer1->setTimeoutCallback(timerCallback.AsStdFunction());
+    auto timer2 = uut->createTickTimer();
+    timer2->setTimeoutCallback(timerCallback.AsStdFunction());
+    auto timer3 = uut->createSingleShotTimer();
+    timer1->start(100ms);
+    timer2->start(40ms);
+    timer3->start(1s);
 
-    EXPECT_CALL(timerCallback1, Call()).Times(3);
-    m_currentTime += 999ms;
+    // timer2 expires at 40ms and 80ms, timer1 at 100ms. Polled at 100ms: lateness 60ms, 20ms and 0ms
+    m_currentTime += 100ms;
+    uut->poll();
     uut->poll();
-    EXPECT_EQ(1ms, timer1->getRemainingMilliseconds());
-    EXPECT_TRUE(timer1->isRunning());
-    EXPECT_FALSE(timer1->expired());
 
-    EXPECT_CALL(timerCallback1, Call()).Times(1);
-    m_currentTime += 1ms;
+    EXPECT_EQ(3u, metrics->lateness.count());
+    EXPECT_EQ(1u, metrics->lateness.bucket(0));
+    EXPECT_EQ(std::uint64_t(std::chrono::nanoseconds(80ms).count()), metrics->lateness.sum());
+    EXPECT_EQ(std::uint64_t(std::chrono::nanoseconds(60ms).count()), metrics->lateness.max());
+    EXPECT_EQ(3u, metrics->callbackDuration.count());
+    EXPECT_EQ(2u, metrics->expirationsPerPoll.count());
+    EXPECT_EQ(3u, metrics->expirationsPerPoll.max());
+    EXPECT_EQ(0u, metrics->expirationsPerPoll.percentile(0.0));
+    EXPECT_EQ(3u, metrics->expirationsPerPoll.percentile(1.0));
+    EXPECT_EQ(2u, metrics->pollDuration.count());
+    EXPECT_EQ(3u, metrics->liveTimers.load());
+    EXPECT_EQ(2u, metrics->armedTimers.load());
+    EXPECT_EQ(0u, metrics->deadTimers.load());
+
+    timer3 = nullptr;
     uut->poll();
-    EXPECT_EQ(250ms, timer1->getRemainingMilliseconds());
-    EXPECT_TRUE(timer1->isRunning());
-    EXPECT_FALSE(timer1->expired());
+    EXPECT_EQ(2u, metrics->liveTimers.load());
+    EXPECT_EQ(1u, metrics->armedTimers.load());
 }
 
-TEST_F(TimerTest, DontStartToShortDurationsForCycleTimerTest)
+TEST_F(TimerManagerTest, SlackReducesFiredDeadlinesTest)
 {
-    StrictMock<MockFunction<void(void)>> timerCallback1;
-
     auto uut = createUUT();
+    auto metrics = uut->enableMetrics(false);
 
-    auto timer1 = uut->createTickTimer();
-    timer1->setTimeoutCallback(timerCallback1.AsStdFunction());
+    std::vector<std::shared_ptr<ITimer>> timers;
+    for (int index = 0; index < 100; ++index)
+    {
+        timers.push_back(uut->createSingleShotTimer());
+        timers.back()->start(1000ms + std::chrono::milliseconds(index * 3), 500ms);
+    }
+    for (int poll = 0; poll < 2000; ++poll)
+    {
+        m_currentTime += 1ms;
+        uut->poll();
+    }
 
-    timer1->start(0ms);
-    EXPECT_FALSE(timer1->isRunning());
-    m_currentTime += 1ms;
-    uut->poll();
+    // 100 deadlines between 1000ms and 1297ms are coalesced to 1024ms and 1280ms and 1536ms
+    EXPECT_EQ(100u, metrics->expirationsPerPoll.sum());
+    EXPECT_EQ(3u, metrics->firedDeadlines.load());
+}
 
-    timer1->start(0s);
-    EXPECT_FALSE(timer1->isRunning());
-    m_currentTime += 1ms;
-    uut->poll();
+TEST_F(TimerManagerTest, RescaleRunsTheTimeAtAMultipleOfTheClockTest)
+{
+    StrictMock<MockFunction<void(void)>> timerCallback;
+    auto uut = createUUT();
+    std::vector<std::chrono::milliseconds> observed;
+    uut->setExpiryObserver([&observed](std::chrono::milliseconds timeout) { observed.push_back(timeout); });
+    auto timer = uut->createSingleShotTimer();
+    timer->setTimeoutCallback(timerCallback.AsStdFunction());
 
-    timer1->start(0min);
-    EXPECT_FALSE(timer1->isRunning());
-    m_currentTime += 1ms;
+    m_currentTime += 10ms;
+    uut->rescale(2.0);
+    EXPECT_EQ(10ms, uut->now());
+    timer->start(100ms);
+    // the observer waits in clock time
+    EXPECT_EQ(50ms, observed.back());
+    m_currentTime += 25ms;
+    EXPECT_EQ(60ms, uut->now());
+    EXPECT_EQ(50ms, timer->getRemainingTime());
+
+    // pause and fast forward work on the rescaled time
+    uut->pause();
+    m_currentTime += 100ms;
+    EXPECT_EQ(60ms, uut->now());
+    uut->resume();
+    uut->fastForward(10ms);
+    EXPECT_EQ(40ms, timer->getRemainingTime());
+    EXPECT_CALL(timerCallback, Call());
+    m_currentTime += 20ms;
     uut->poll();
 
-    timer1->start(0h);
-    EXPECT_FALSE(timer1->isRunning());
-    m_currentTime += 1ms;
-    uut->poll();
+    uut->rescale(0.0);
+    uut->rescale(0.5);
+    timer->start(100ms);
+    m_currentTime += 100ms;
+    EXPECT_EQ(50ms, timer->getRemainingTime());
+
+    // a timer outliving the manager keeps the rate
+    uut = nullptr;
+    m_currentTime += 20ms;
+    EXPECT_EQ(40ms, timer->getRemainingTime());
 }
 
-TEST_F(TimerTest, ChronoSteadyClockTestTest)
+TEST_F(TimerManagerTest, MetricsDoNotMeasureDispatchedCallbacksTest)
 {
-    StrictMock<MockFunction<void(void)>> timerCallback1;
+    auto uut = createUUT();
+    auto metrics = uut->enableMetrics(true);
+    std::vector<std::function<void()>> dispatched;
+    uut->setCallbackExecutor([&dispatched](std::uint64_t, std::function<void()> callback) {
+        std::this_thread::sleep_for(20ms);
+        dispatched.push_back(std::move(callback));
+    });
+    int calls = 0;
+    auto timer = uut->createSingleShotTimer();
+    timer->setTimeoutCallback([&calls]() { ++calls; });
+    timer->start(10ms);
+    auto handle = uut->createSingleShotTimerId();
+    uut->setTimeoutCallback(handle, [&calls]() { ++calls; });
+    uut->start(handle, 20ms);
+
+    // the handle timer is called in poll, its sample does not contain the dispatch before it
+    m_currentTime += 20ms;
+    uut->poll();
+    EXPECT_EQ(1, calls);
+    EXPECT_EQ(1u, metrics->callbackDuration.count());
+    EXPECT_GT(std::uint64_t(std::chrono::nanoseconds(20ms).count()), metrics->callbackDuration.max());
 
-    auto uut = std::make_shared<TimerManager>();
+    for (auto& callback : dispatched)
+    {
+        callback();
+    }
+    EXPECT_EQ(2, calls);
+}
 
-    auto timer1 = uut->createTickTimer();
-    timer1->setTimeoutCallback(timerCallback1.AsStdFunction());
+TEST_F(TimerManagerTest, BoundedPollResumesInExpiryOrderTest)
+{
+    auto uut = createUUT();
+    std::vector<std::string> expired;
+    auto tickTimer = uut->createTickTimer();
+    auto singleShotTimer = uut->createSingleShotTimer();
+    auto startedInCallback = uut->createSingleShotTimer();
+    tickTimer->setTimeoutCallback([&]() { expired.push_back("tick"); });
+    singleShotTimer->setTimeoutCallback([&]() {
+        expired.push_back("single");
+        // counts from the expire time of the callback's timer, 25ms, not from the time of the poll
+        startedInCallback->start(10ms);
+    });
+    startedInCallback->setTimeoutCallback([&]() { expired.push_back("started in callback"); });
+    tickTimer->start(10ms);
+    singleShotTimer->start(25ms);
+
+    // a stall of 50ms, the tick timer is behind by 5 periods
+    m_currentTime += 50ms;
+    auto result = uut->poll(2);
+    EXPECT_EQ(2u, result.expired);
+    EXPECT_EQ(2u, result.overdue);
+    EXPECT_EQ((std::vector<std::string>{"tick", "tick"}), expired);
+
+    result = uut->pollFor(0ns);
+    EXPECT_EQ(1u, result.expired);
+    EXPECT_EQ(2u, result.overdue);
+    EXPECT_EQ("single", expired.back());
+
+    result = uut->poll(std::numeric_limits<std::size_t>::max());
+    EXPECT_EQ(4u, result.expired);
+    EXPECT_EQ(0u, result.overdue);
+    EXPECT_EQ((std::vector<std::string>{"tick", "tick", "single", "tick", "started in callback", "tick", "tick"}), expired);
+    EXPECT_EQ(10ms, tickTimer->getRemainingTime());
+
+    EXPECT_EQ(0u, uut->poll(0).expired);
+}
 
-    timer1->start(250ms);
-    std::this_thread::sleep_for(250ms);
-    EXPECT_CALL(timerCallback1, Call()).Times(1);
+TEST_F(TimerManagerTest, BoundedPollCountsOverdueWithoutAllocationTest)
+{
+    auto now = 0ms;
+    auto uut = std::make_shared<TimerManager>([&now]() { return now; });
+    std::vector<std::shared_ptr<ITimer>> timers;
+    for (int index = 0; index < 100; ++index)
+    {
+        timers.push_back(uut->createTickTimer());
+        timers.back()->start(std::chrono::milliseconds(1 + index % 7));
+    }
+    now += 10ms;
     uut->poll();
+
+    // an overloaded poll stops at its bound and walks the due timers left behind
+    AllocationCounter counter;
+    now += 10ms;
+    auto result = uut->poll(10);
+    EXPECT_EQ(10u, result.expired);
+    EXPECT_LT(0u, result.overdue);
+    EXPECT_EQ(0u, counter.allocations());
 }
 
-TEST_F(TimerTest, RemoveExpiredWeakPtrTest)
+TEST_F(TimerManagerTest, CrossThreadCommandsAreExecutedInPollTest)
 {
     StrictMock<MockFunction<void(void)>> timerCallback1;
-
+    StrictMock<MockFunction<void(void)>> timerCallback2;
     auto uut = createUUT();
+    uut->enableCrossThreadCommands();
 
     auto timer1 = uut->createSingleShotTimer();
-    timer1->setTimeoutCallback(timerCallback1.AsStdFunction());
+    auto timer2 = uut->createSingleShotTimer();
+    timer2->setTimeoutCallback(timerCallback2.AsStdFunction());
 
-    timer1->start(500ms);
-    EXPECT_CALL(timerCallback1, Call()).Times(1);
-    uut->fastForward(500ms);
+    std::thread([&]() {
+        timer1->setTimeoutCallback(timerCallback1.AsStdFunction());
+        timer1->start(100ms);
+        timer2->start(100ms);
+    }).join();
+    EXPECT_FALSE(timer1->isRunning());
 
-    timer1->start(500ms);
-    EXPECT_CALL(timerCallback1, Call()).Times(0);
-    timer1 = nullptr;
-    uut->fastForward(500ms);
+    m_currentTime += 50ms;
+    uut->poll();
+    EXPECT_TRUE(timer1->isRunning());
+    EXPECT_EQ(100ms, timer1->getRemainingMilliseconds());
+
+    std::thread([&]() {
+        timer2->stop();
+    }).join();
+
+    EXPECT_CALL(timerCallback1, Call());
+    uut->fastForward(100ms);
+    EXPECT_FALSE(timer2->isRunning());
+
+    // calls of the owner thread are executed directly
+    timer2->start(100ms);
+    EXPECT_TRUE(timer2->isRunning());
+}
+
+TEST_F(TimerManagerTest, CrossThreadCommandsReuseQueueNodesTest)
+{
+    auto uut = createUUT();
+    uut->enableCrossThreadCommands();
+    auto timer = uut->createSingleShotTimer();
+
+    std::thread([&]() {
+        timer->start(100ms);
+        timer->stop();
+    }).join();
+    uut->poll();
+
+    // nodes freed by the poll carry the next commands
+    std::size_t allocations = 1;
+    std::thread([&]() {
+        AllocationCounter counter;
+        timer->start(100ms);
+        timer->stop();
+        allocations = counter.allocations();
+    }).join();
+    uut->poll();
+    EXPECT_EQ(0u, allocations);
+    EXPECT_FALSE(timer->isRunning());
+}
+
+TEST_F(TimerManagerTest, CrossThreadCommandsOfConcurrentProducersTest)
+{
+    auto uut = createUUT();
+    uut->enableCrossThreadCommands();
+    std::vector<std::shared_ptr<ITimer>> timers;
+    for (int index = 0; index < 4; ++index)
+    {
+        timers.push_back(uut->createSingleShotTimer());
+    }
+
+    // producers take recycled nodes while the poll recycles them, the last command of each timer wins
+    std::atomic<int> finished{0};
+    std::vector<std::thread> producers;
+    for (int index = 0; index < 4; ++index)
+    {
+        producers.emplace_back([&, index]() {
+            for (int command = 0; command < 10000; ++command)
+            {
+                timers[index]->start(std::chrono::milliseconds(100 + index));
+                timers[index]->stop();
+            }
+            timers[index]->start(std::chrono::milliseconds(100 + index));
+            ++finished;
+        });
+    }
+    while (finished < 4)
+    {
+        uut->poll();
+    }
+    for (auto& producer : producers)
+    {
+        producer.join();
+    }
+    uut->poll();
+    for (int index = 0; index < 4; ++index)
+    {
+        EXPECT_EQ(std::chrono::milliseconds(100 + index), timers[index]->getRemainingMilliseconds());
+    }
+}
+
+TEST_F(TimerManagerTest, CrossThreadReleasedTimersAreDeletedByOwnerTest)
+{
+    StrictMock<MockFunction<void(void)>> timerCallback1;
+    auto uut = createUUT();
+    uut->enableCrossThreadCommands();
+
+    auto timer1 = uut->createSingleShotTimer();
+    timer1->setTimeoutCallback(timerCallback1.AsStdFunction());
+    timer1->start(100ms);
+    auto timer2 = uut->createSingleShotTimer();
+
+    std::thread([timer = std::move(timer1)]() mutable {
+        timer->start(200ms);
+        timer = nullptr;
+    }).join();
+    std::thread([timer = std::move(timer2)]() mutable {
+        timer->start(200ms);
+    }).join();
+
+    EXPECT_CALL(timerCallback1, Call()).Times(0);
+    uut->fastForward(1000ms);
+}
+
+TEST_P(TimerTest, StopAndDeleteArmedTimersDuringPollTest)
+{
+    StrictMock<MockFunction<void(void)>> timerCallback1;
+    StrictMock<MockFunction<void(void)>> timerCallback2;
+    StrictMock<MockFunction<void(void)>> timerCallback3;
+    auto uut = createUUT();
+
+    auto timer1 = uut->createSingleShotTimer();
+    timer1->setTimeoutCallback(timerCallback1.AsStdFunction());
+    auto timer2 = uut->createSingleShotTimer();
+    timer2->setTimeoutCallback(timerCallback2.AsStdFunction());
+    auto timer3 = uut->createTickTimer();
+    timer3->setTimeoutCallback(timerCallback3.AsStdFunction());
+
+    timer1->start(100ms);
+    timer2->start(200ms);
+    timer3->start(200ms);
+
+    EXPECT_CALL(timerCallback1, Call()).WillOnce(Invoke([&]() {
+        timer2->stop();
+        timer3 = nullptr;
+    }));
+    uut->fastForward(1000ms);
+
+    timer2->start(100ms);
+    EXPECT_CALL(timerCallback2, Call());
+    uut->fastForward(100ms);
+}
+
+TEST_P(TimerTest, DeleteDueTimersDuringPollTest)
+{
+    auto uut = createUUT();
+    std::vector<int> fired;
+    std::vector<std::shared_ptr<ITimer>> timers;
+    for (int index = 0; index < 8; ++index)
+    {
+        timers.push_back(uut->createSingleShotTimer());
+        timers.back()->setTimeoutCallback([&fired, index]() { fired.push_back(index); });
+        timers.back()->start(std::chrono::milliseconds(10 * (index + 1)));
+    }
+    // due timers destroyed by an earlier callback of the same poll are skipped, the others keep their order
+    timers[0]->setTimeoutCallback([&]() {
+        fired.push_back(0);
+        timers[2].reset();
+        timers[4].reset();
+        timers[6].reset();
+        timers.push_back(uut->createSingleShotTimer());
+    });
+    uut->fastForward(100ms);
+    EXPECT_EQ((std::vector<int>{0, 1, 3, 5, 7}), fired);
+}
+
+TEST_P(TimerTest, PauseAndFastForwardTest)
+{
+    StrictMock<MockFunction<void(void)>> timerCallback1;
+
+    auto uut = createUUT();
+
+    auto timer1 = uut->createSingleShotTimer();
+    timer1->setTimeoutCallback(timerCallback1.AsStdFunction());
+    EXPECT_FALSE(timer1->isRunning());
+    timer1->start(1100ms);
+
+    uut->pause();
+
+    uut->fastForward(1000ms);
+    m_currentTime += 1000ms; // this should not raise timer event since we are in paused mode
+    uut->poll();
+    EXPECT_EQ(100ms, timer1->getRemainingMilliseconds());
+    EXPECT_CALL(timerCallback1, Call());
+    uut->fastForward(100ms);
+    EXPECT_EQ(0ms, timer1->getRemainingMilliseconds());
+
+    EXPECT_CALL(timerCallback1, Call()).Times(0);
+    uut->resume();
+    timer1->start(500ms);
+    m_currentTime += 499ms;
+    uut->poll();
+    EXPECT_EQ(1ms, timer1->getRemainingMilliseconds());
+
+    m_currentTime += 1ms;
+    EXPECT_CALL(timerCallback1, Call());
+    uut->poll();
+    EXPECT_EQ(0ms, timer1->getRemainingMilliseconds());
+}
+
+TEST_P(TimerTest, CheckTimeCorrectnessDuringManipulationsTest)
+{
+    StrictMock<MockFunction<void(void)>> timerCallback1;
+
+    auto uut = createUUT();
+
+    auto timer1 = uut->createTickTimer();
+    timer1->setTimeoutCallback(timerCallback1.AsStdFunction());
+
+    timer1->start(500ms);
+
+    EXPECT_EQ(500ms, timer1->getRemainingMilliseconds());
+    m_currentTime += 100ms;
+    EXPECT_EQ(400ms, timer1->getRemainingMilliseconds());
+    uut->fastForward(2ms);
+    uut->pause();
+    EXPECT_EQ(398ms, timer1->getRemainingMilliseconds());
+
+    uut->fastForward(2ms);
+    EXPECT_EQ(396ms, timer1->getRemainingMilliseconds());
+    m_currentTime += 1ms;
+    EXPECT_EQ(396ms, timer1->getRemainingMilliseconds());
+
+    uut->resume();
+
+    m_currentTime += 395ms;
+    uut->poll();
+    EXPECT_EQ(1ms, timer1->getRemainingMilliseconds());
+
+    EXPECT_CALL(timerCallback1, Call());
+    uut->fastForward(1ms);
+}
+
+TEST_P(TimerTest, CycleTimerTest)
+{
+    StrictMock<MockFunction<void(void)>> timerCallback1;
+
+    auto uut = createUUT();
+
+    auto timer1 = uut->createTickTimer();
+    timer1->setTimeoutCallback(timerCallback1.AsStdFunction());
+    EXPECT_FALSE(timer1->isRunning());
+    EXPECT_FALSE(timer1->expired());
+    timer1->start(250ms);
+
+    EXPECT_CALL(timerCallback1, Call()).Times(3);
+    m_currentTime += 999ms;
+    uut->poll();
+    EXPECT_EQ(1ms, timer1->getRemainingMilliseconds());
+    EXPECT_TRUE(timer1->isRunning());
+    EXPECT_FALSE(timer1->expired());
+
+    EXPECT_CALL(timerCallback1, Call()).Times(1);
+    m_currentTime += 1ms;
+    uut->poll();
+    EXPECT_EQ(250ms, timer1->getRemainingMilliseconds());
+    EXPECT_TRUE(timer1->isRunning());
+    EXPECT_FALSE(timer1->expired());
+}
+
+TEST_P(TimerTest, MissedTickPolicyTest)
+{
+    auto uut = createUUT();
+    std::map<MissedTickPolicy, std::vector<std::uint64_t>> missedTicks;
+    std::vector<std::shared_ptr<ITimer>> timers;
+    for (auto policy : {MissedTickPolicy::fireAll, MissedTickPolicy::fireOnce, MissedTickPolicy::skipToPhase})
+    {
+        auto timer = uut->createTickTimer(policy);
+        auto rawTimer = timer.get();
+        timer->setTimeoutCallback([rawTimer, &missedTicks]() {
+            missedTicks[rawTimer->missedTickPolicy()].push_back(rawTimer->missedTicks());
+        });
+        timer->start(10ms);
+        timers.push_back(timer);
+    }
+    EXPECT_EQ(MissedTickPolicy::fireAll, uut->createSingleShotTimer()->missedTickPolicy());
+
+    // a stall of 45ms, ticks at 10ms, 20ms, 30ms and 40ms are due
+    m_currentTime += 45ms;
+    uut->poll();
+    EXPECT_EQ((std::vector<std::uint64_t>{0, 0, 0, 0}), missedTicks[MissedTickPolicy::fireAll]);
+    EXPECT_EQ((std::vector<std::uint64_t>{3}), missedTicks[MissedTickPolicy::fireOnce]);
+    EXPECT_EQ((std::vector<std::uint64_t>{3}), missedTicks[MissedTickPolicy::skipToPhase]);
+    // fireOnce counts the next period from the poll, the others stay on the 10ms grid
+    EXPECT_EQ(5ms, timers[0]->getRemainingTime());
+    EXPECT_EQ(10ms, timers[1]->getRemainingTime());
+    EXPECT_EQ(5ms, timers[2]->getRemainingTime());
+
+    m_currentTime += 5ms;
+    uut->poll();
+    EXPECT_EQ(5u, missedTicks[MissedTickPolicy::fireAll].size());
+    EXPECT_EQ(1u, missedTicks[MissedTickPolicy::fireOnce].size());
+    EXPECT_EQ((std::vector<std::uint64_t>{3, 0}), missedTicks[MissedTickPolicy::skipToPhase]);
+}
+
+TEST_P(TimerTest, StartAtAndAlignedTest)
+{
+    auto uut = createUUT();
+    std::vector<std::string> calls;
+    auto record = [&calls](const char* name) { return [&calls, name]() { calls.push_back(name); }; };
+    // the manager time is the mock clock here
+    m_currentTime = 1234ms;
+    auto singleShot = uut->createSingleShotTimer();
+    singleShot->setTimeoutCallback(record("singleShot"));
+    singleShot->startAt(1300ms);
+    auto first = uut->createTickTimer(MissedTickPolicy::skipToPhase);
+    first->setTimeoutCallback(record("first"));
+    first->startAligned(100ms, 30ms);
+    EXPECT_EQ(96ms, first->getRemainingTime());
+
+    // started later, the second one joins the grid of the first one
+    m_currentTime += 26ms;
+    auto second = uut->createTickTimer();
+    second->setTimeoutCallback(record("second"));
+    second->startAligned(100ms, 30ms);
+    EXPECT_EQ(70ms, second->getRemainingTime());
+    auto anchored = uut->createTickTimer();
+    anchored->setTimeoutCallback(record("anchored"));
+    anchored->startAt(1400ms, 200ms);
+    // tick timers need a period
+    auto noPeriod = uut->createTickTimer();
+    noPeriod->startAt(1400ms);
+    EXPECT_FALSE(noPeriod->isRunning());
+
+    m_currentTime = 1330ms;
+    uut->poll();
+    EXPECT_EQ((std::vector<std::string>{"singleShot", "first", "second"}), calls);
+    EXPECT_EQ(100ms, first->getRemainingTime());
+    EXPECT_EQ(100ms, second->getRemainingTime());
+
+    // late polls do not move the grids
+    calls.clear();
+    m_currentTime = 1445ms;
+    uut->poll();
+    EXPECT_EQ((std::vector<std::string>{"anchored", "first", "second"}), calls);
+    EXPECT_EQ(155ms, anchored->getRemainingTime());
+    EXPECT_EQ(85ms, first->getRemainingTime());
+
+    // a time already reached expires in the next poll, touch keeps the duration of the previous start then
+    calls.clear();
+    singleShot->startAt(1000ms);
+    uut->poll();
+    EXPECT_EQ((std::vector<std::string>{"singleShot"}), calls);
+    singleShot->touch();
+    EXPECT_EQ(66ms, singleShot->getRemainingTime());
+    // without a previous start the smallest duration is left
+    auto fresh = uut->createSingleShotTimer();
+    fresh->startAt(1000ms);
+    uut->poll();
+    fresh->touch();
+    EXPECT_TRUE(fresh->isRunning());
+    EXPECT_EQ(1ms, fresh->getRemainingTime());
+}
+
+TEST_P(TimerTest, TimerGroupTest)
+{
+    auto uut = createUUT();
+    auto group = uut->createTimerGroup();
+    int groupCalls = 0;
+    int otherCalls = 0;
+    auto groupTick = group->createTickTimer();
+    auto groupSingleShot = group->createSingleShotTimer();
+    auto other = uut->createSingleShotTimer();
+    groupTick->setTimeoutCallback([&groupCalls]() { ++groupCalls; });
+    groupSingleShot->setTimeoutCallback([&groupCalls]() { ++groupCalls; });
+    other->setTimeoutCallback([&otherCalls]() { ++otherCalls; });
+    EXPECT_EQ(2u, group->size());
+
+    // the time of paused timers stands still, resume shifts them by the paused period
+    groupTick->start(10ms);
+    groupSingleShot->start(25ms);
+    other->start(25ms);
+    m_currentTime += 5ms;
+    uut->poll();
+    group->pause();
+    EXPECT_TRUE(group->isPaused());
+    EXPECT_TRUE(groupTick->isRunning());
+    m_currentTime += 100ms;
+    uut->poll();
+    EXPECT_EQ(0, groupCalls);
+    EXPECT_EQ(1, otherCalls);
+    EXPECT_EQ(5ms, groupTick->getRemainingTime());
+    EXPECT_EQ(20ms, groupSingleShot->getRemainingTime());
+    group->resume();
+    EXPECT_FALSE(group->isPaused());
+    m_currentTime += 5ms;
+    uut->poll();
+    EXPECT_EQ(1, groupCalls);
+    EXPECT_EQ(10ms, groupTick->getRemainingTime());
+
+    // stopAll stops only the timers of the group
+    other->start(10ms);
+    group->stopAll();
+    EXPECT_FALSE(groupTick->isRunning());
+    EXPECT_FALSE(groupSingleShot->isRunning());
+    EXPECT_TRUE(other->isRunning());
+
+    // deleted timers leave the group, destroying the group stops its timers
+    groupSingleShot.reset();
+    EXPECT_EQ(1u, group->size());
+    groupTick->start(10ms);
+    group.reset();
+    EXPECT_FALSE(groupTick->isRunning());
+    m_currentTime += 50ms;
+    uut->poll();
+    EXPECT_EQ(1, groupCalls);
+    EXPECT_EQ(2, otherCalls);
+}
+
+TEST_P(TimerTest, CallbackReplacesItselfTest)
+{
+    StrictMock<MockFunction<void(int)>> timerCallback;
+    auto uut = createUUT();
+    auto timer = uut->createTickTimer();
+    auto value = std::make_unique<int>(1);
+
+    // the running callback is replaced before it uses its own move-only capture
+    timer->setTimeoutCallback([&timerCallback, &timer, value = std::move(value)]() {
+        timer->setTimeoutCallback([&timerCallback]() { timerCallback.Call(2); });
+        timerCallback.Call(*value);
+    });
+    timer->start(100ms);
+
+    Sequence seq;
+    EXPECT_CALL(timerCallback, Call(1)).InSequence(seq);
+    EXPECT_CALL(timerCallback, Call(2)).Times(2).InSequence(seq);
+    m_currentTime += 300ms;
+    uut->poll();
+}
+
+TEST_P(TimerTest, DontStartToShortDurationsForCycleTimerTest)
+{
+    StrictMock<MockFunction<void(void)>> timerCallback1;
+
+    auto uut = createUUT();
+
+    auto timer1 = uut->createTickTimer();
+    timer1->setTimeoutCallback(timerCallback1.AsStdFunction());
+
+    timer1->start(0ms);
+    EXPECT_FALSE(timer1->isRunning());
+    m_currentTime += 1ms;
+    uut->poll();
+
+    timer1->start(0s);
+    EXPECT_FALSE(timer1->isRunning());
+    m_currentTime += 1ms;
+    uut->poll();
+
+    timer1->start(0min);
+    EXPECT_FALSE(timer1->isRunning());
+    m_currentTime += 1ms;
+    uut->poll();
+
+    timer1->start(0h);
+    EXPECT_FALSE(timer1->isRunning());
+    m_currentTime += 1ms;
+    uut->poll();
+}
+
+TEST_P(TimerTest, ChronoSteadyClockTestTest)
+{
+    StrictMock<MockFunction<void(void)>> timerCallback1;
+
+    auto uut = GetParam()(getChronoSteadyClockTicks);
+
+    auto timer1 = uut->createTickTimer();
+    timer1->setTimeoutCallback(timerCallback1.AsStdFunction());
+
+    timer1->start(250ms);
+    std::this_thread::sleep_for(250ms);
+    EXPECT_CALL(timerCallback1, Call()).Times(1);
+    uut->poll();
+}
+
+TEST_P(TimerTest, TimeUntilNextExpiryTest)
+{
+    StrictMock<MockFunction<void(void)>> timerCallback1;
+    auto uut = createUUT();
+
+    EXPECT_EQ(ITimerManager::noExpiry(), uut->timeUntilNextExpiry());
+
+    auto timer1 = uut->createSingleShotTimer();
+    timer1->setTimeoutCallback(timerCallback1.AsStdFunction());
+    auto timer2 = uut->createSingleShotTimer();
+    EXPECT_EQ(ITimerManager::noExpiry(), uut->timeUntilNextExpiry());
+
+    timer1->start(1s);
+    timer2->start(300ms);
+    EXPECT_EQ(300ms, uut->timeUntilNextExpiry());
+    m_currentTime += 100ms;
+    EXPECT_EQ(200ms, uut->timeUntilNextExpiry());
+    timer2->stop();
+    EXPECT_EQ(900ms, uut->timeUntilNextExpiry());
+
+    uut->pause();
+    uut->fastForward(400ms);
+    EXPECT_EQ(500ms, uut->timeUntilNextExpiry());
+    uut->resume();
+
+    m_currentTime += 600ms; // overdue, not polled yet
+    EXPECT_EQ(0ms, uut->timeUntilNextExpiry());
+    EXPECT_CALL(timerCallback1, Call());
+    uut->poll();
+    EXPECT_EQ(ITimerManager::noExpiry(), uut->timeUntilNextExpiry());
+}
+
+TEST_P(TimerTest, SlackCoalescesDeadlinesTest)
+{
+    StrictMock<MockFunction<void(int)>> timerCallback;
+    auto uut = createUUT();
+
+    std::vector<std::shared_ptr<ITimer>> timers;
+    for (int index = 0; index < 3; ++index)
+    {
+        timers.push_back(uut->createSingleShotTimer());
+        timers.back()->setTimeoutCallback([&timerCallback, index]() { timerCallback.Call(index); });
+    }
+    auto tick = uut->createTickTimer();
+    tick->setTimeoutCallback([&timerCallback]() { timerCallback.Call(3); });
+
+    // windows [1000, 2000], [1100, 2100], [1200, 2200] on a 512ms grid
+    timers[0]->start(1000ms, 1000ms);
+    timers[1]->start(1100ms, 1000ms);
+    timers[2]->start(1200ms, 1000ms);
+    // windows [700, 1000], [1724, 2024] on a 256ms grid
+    tick->start(700ms, 300ms);
+    EXPECT_EQ(768ms, uut->timeUntilNextExpiry());
+
+    EXPECT_CALL(timerCallback, Call(3));
+    m_currentTime += 768ms;
+    uut->poll();
+    EXPECT_EQ(256ms, uut->timeUntilNextExpiry());
+
+    EXPECT_CALL(timerCallback, Call(0));
+    m_currentTime += 256ms;
+    uut->poll();
+    EXPECT_EQ(512ms, uut->timeUntilNextExpiry());
+
+    Sequence seq;
+    EXPECT_CALL(timerCallback, Call(1)).InSequence(seq);
+    EXPECT_CALL(timerCallback, Call(2)).InSequence(seq);
+    EXPECT_CALL(timerCallback, Call(3)).InSequence(seq);
+    m_currentTime += 512ms;
+    uut->poll();
+}
+
+TEST_P(TimerTest, RestartAndTouchTest)
+{
+    StrictMock<MockFunction<void(void)>> timerCallback;
+    auto uut = createUUT();
+    auto timer = uut->createSingleShotTimer();
+    timer->setTimeoutCallback(timerCallback.AsStdFunction());
+
+    // touch and restart start stopped timers
+    timer->touch();
+    EXPECT_FALSE(timer->isRunning());
+    timer->restart(100ms);
+    EXPECT_TRUE(timer->isRunning());
+
+    m_currentTime += 60ms;
+    timer->touch();
+    EXPECT_EQ(100ms, timer->getRemainingMilliseconds());
+    m_currentTime += 40ms;
+    uut->poll();
+    EXPECT_EQ(60ms, timer->getRemainingMilliseconds());
+
+    // moving the deadline earlier
+    timer->restart(20ms);
+    EXPECT_EQ(20ms, uut->timeUntilNextExpiry());
+    EXPECT_CALL(timerCallback, Call());
+    m_currentTime += 20ms;
+    uut->poll();
+    EXPECT_FALSE(timer->isRunning());
+}
+
+TEST_P(TimerTest, TouchedTimersExpireAtTheirLastDeadlineTest)
+{
+    auto uut = createUUT();
+    std::vector<std::shared_ptr<ITimer>> timers;
+    std::vector<std::chrono::milliseconds> durations(50);
+    std::vector<std::chrono::milliseconds> deadlines(50);
+    std::vector<std::chrono::milliseconds> expired(50, -1ms);
+    for (std::size_t index = 0; index < deadlines.size(); ++index)
+    {
+        timers.push_back(uut->createSingleShotTimer());
+        timers.back()->setTimeoutCallback([&, index]() { expired[index] = m_currentTime; });
+        durations[index] = std::chrono::milliseconds(10 + index);
+        timers.back()->start(durations[index]);
+        deadlines[index] = m_currentTime + durations[index];
+    }
+    for (unsigned step = 1; step <= 200; ++step)
+    {
+        // touch timers a few times, also expired ones, some get a new duration
+        const auto index = (step * 7) % timers.size();
+        if (step < 120)
+        {
+            if (step % 3)
+            {
+                timers[index]->touch();
+            }
+            else
+            {
+                durations[index] = std::chrono::milliseconds(5 + step % 17);
+                timers[index]->restart(durations[index]);
+            }
+            deadlines[index] = m_currentTime + durations[index];
+        }
+        m_currentTime += 1ms;
+        uut->poll();
+    }
+    for (std::size_t index = 0; index < deadlines.size(); ++index)
+    {
+        EXPECT_EQ(deadlines[index], expired[index]) << index;
+    }
+}
+
+TEST_P(TimerTest, WaitAndPollSleepsUntilNextExpiryTest)
+{
+    StrictMock<MockFunction<void(void)>> timerCallback1;
+
+    auto uut = GetParam()(getChronoSteadyClockTicks);
+
+    auto timer1 = uut->createSingleShotTimer();
+    timer1->setTimeoutCallback(timerCallback1.AsStdFunction());
+    timer1->start(50ms);
+
+    const auto begin = std::chrono::steady_clock::now();
+    EXPECT_CALL(timerCallback1, Call()).Times(1);
+    uut->waitAndPoll(10s);
+    const auto waited = std::chrono::steady_clock::now() - begin;
+    EXPECT_GE(waited, 49ms); // steady ticks are truncated to milliseconds
+    EXPECT_LT(waited, 5s);
+}
+
+TEST_P(TimerTest, WakeupInterruptsWaitAndPollTest)
+{
+    auto uut = GetParam()(getChronoSteadyClockTicks);
+
+    const auto begin = std::chrono::steady_clock::now();
+    std::thread waker([&]() {
+        std::this_thread::sleep_for(20ms);
+        uut->wakeup();
+    });
+    uut->waitAndPoll(std::chrono::milliseconds::max());
+    waker.join();
+    EXPECT_LT(std::chrono::steady_clock::now() - begin, 5s);
+
+    // a wakeup without waiter is kept for the next wait
+    uut->wakeup();
+    uut->waitAndPoll(10s);
+    EXPECT_LT(std::chrono::steady_clock::now() - begin, 5s);
 }
 
-TEST_F(TimerTest, RemoveExpiredWeakPtrDirectlyAfterCallbackTest)
+TEST_P(TimerTest, RemoveExpiredWeakPtrTest)
+{
+    StrictMock<MockFunction<void(void)>> timerCallback1;
+
+    auto uut = createUUT();
+
+    auto timer1 = uut->createSingleShotTimer();
+    timer1->setTimeoutCallback(timerCallback1.AsStdFunction());
+
+    timer1->start(500ms);
+    EXPECT_CALL(timerCallback1, Call()).Times(1);
+    uut->fastForward(500ms);
+
+    timer1->start(500ms);
+    EXPECT_CALL(timerCallback1, Call()).Times(0);
+    timer1 = nullptr;
+    uut->fastForward(500ms);
+}
+
+TEST_P(TimerTest, RemoveExpiredWeakPtrDirectlyAfterCallbackTest)
 {
     StrictMock<MockFunction<void(void)>> timerCallback1;
 
@@ -303,7 +1332,7 @@ TEST_F(TimerTest, RemoveExpiredWeakPtrDirectlyAfterCallbackTest)
     uut->poll();
 }
 
-TEST_F(TimerTest, NoPauseDuringPollTest)
+TEST_P(TimerTest, NoPauseDuringPollTest)
 {
     StrictMock<MockFunction<void(void)>> timerCallback1;
 
@@ -325,7 +1354,7 @@ TEST_F(TimerTest, NoPauseDuringPollTest)
     uut->poll();
 }
 
-TEST_F(TimerTest, NoResumeDuringPollTest)
+TEST_P(TimerTest, NoResumeDuringPollTest)
 {
     StrictMock<MockFunction<void(void)>> timerCallback1;
 
@@ -347,7 +1376,7 @@ TEST_F(TimerTest, NoResumeDuringPollTest)
     uut->poll();
 }
 
-TEST_F(TimerTest, NoFastForwardDuringPollTest)
+TEST_P(TimerTest, NoFastForwardDuringPollTest)
 {
     StrictMock<MockFunction<void(void)>> timerCallback1;
 
@@ -365,7 +1394,7 @@ TEST_F(TimerTest, NoFastForwardDuringPollTest)
     uut->poll();
 }
 
-TEST_F(TimerTest, PollDuringDuringPollDoesNotDirsturbBehaviorTest)
+TEST_P(TimerTest, PollDuringDuringPollDoesNotDirsturbBehaviorTest)
 {
     StrictMock<MockFunction<void(void)>> timerCallback1;
 
@@ -382,7 +1411,7 @@ TEST_F(TimerTest, PollDuringDuringPollDoesNotDirsturbBehaviorTest)
     uut->poll();
 }
 
-TEST_F(TimerTest, DeleteManagerKeepsDoesNotAccessFreedMemoryTest)
+TEST_P(TimerTest, DeleteManagerKeepsDoesNotAccessFreedMemoryTest)
 {
     StrictMock<MockFunction<void(void)>> timerCallback1;
 
@@ -406,7 +1435,813 @@ TEST_F(TimerTest, DeleteManagerKeepsDoesNotAccessFreedMemoryTest)
     EXPECT_EQ(300ms, timer1->getRemainingMilliseconds());
 }
 
-TEST_F(TimerTest, OstreamTest)
+TEST_F(TimerManagerTest, CallbackExecutorKeepsOrderPerKeyTest)
+{
+    auto uut = createUUT();
+    ThreadPoolExecutor executor(4);
+    uut->setCallbackExecutor([&executor](std::uint64_t key, std::function<void()> callback) {
+        executor.execute(key, std::move(callback));
+    });
+    const auto pollThread = std::this_thread::get_id();
+    std::mutex mutex;
+    std::map<std::string, std::vector<int>> calls;
+    std::atomic<int> callsOnPollThread{0};
+    auto record = [&](const std::string& name, int value) {
+        callsOnPollThread += std::this_thread::get_id() == pollThread ? 1 : 0;
+        // slow callbacks, a pool without ordering would reorder them
+        std::this_thread::sleep_for(std::chrono::microseconds(100 * (value % 3)));
+        std::lock_guard<std::mutex> lock(mutex);
+        calls[name].push_back(value);
+    };
+
+    // two tick timers sharing a key expire alternately, the others have their own keys
+    std::vector<std::shared_ptr<ITimer>> timers;
+    for (int index = 0; index < 6; ++index)
+    {
+        timers.push_back(uut->createTickTimer());
+        auto count = std::make_shared<int>(0);
+        const auto name = index < 2 ? std::string("group") : std::to_string(index);
+        timers.back()->setTimeoutCallback(
+            std::function<void()>([record, count, name, index]() { record(name, index < 2 ? index : ++*count); }));
+        if (index < 2)
+        {
+            uut->setOrderingKey(*timers.back(), 1000);
+        }
+    }
+    timers[0]->start(10ms);
+    for (int index = 2; index < 6; ++index)
+    {
+        timers[index]->start(1ms);
+    }
+    m_currentTime += 5ms;
+    uut->poll();
+    timers[1]->start(10ms);
+    uut->fastForward(100ms);
+    executor.waitIdle();
+
+    EXPECT_EQ(0, callsOnPollThread.load());
+    std::vector<int> expectedGroup;
+    for (int time = 10; time <= 105; time += 5)
+    {
+        expectedGroup.push_back(time % 10 == 0 ? 0 : 1);
+    }
+    EXPECT_EQ(expectedGroup, calls["group"]);
+    for (int index = 2; index < 6; ++index)
+    {
+        auto& values = calls[std::to_string(index)];
+        EXPECT_EQ(105u, values.size());
+        EXPECT_TRUE(std::is_sorted(values.begin(), values.end()));
+    }
+}
+
+TEST_F(TimerManagerTest, CallbackExecutorReleasesTimersOnOwnerThreadTest)
+{
+    auto uut = createUUT();
+    ThreadPoolExecutor executor(1);
+    uut->setCallbackExecutor([&executor](std::uint64_t key, std::function<void()> callback) {
+        executor.execute(key, std::move(callback));
+    });
+    auto timer = uut->createSingleShotTimer();
+    std::weak_ptr<ITimer> watch = timer;
+    std::promise<void> released;
+    auto releasedFuture = released.get_future().share();
+    auto rawTimer = timer.get();
+    timer->setTimeoutCallback([rawTimer, releasedFuture]() {
+        releasedFuture.wait();
+        // queued for the owner thread, the callback holds the last reference meanwhile
+        rawTimer->start(50ms);
+    });
+    timer->start(10ms);
+    uut->fastForward(10ms);
+    timer = nullptr;
+    released.set_value();
+    executor.waitIdle();
+    EXPECT_FALSE(watch.expired());
+    uut->poll();
+    EXPECT_TRUE(watch.expired());
+
+    // only timers of the manager take an ordering key
+    TimingWheelTimerManager other(m_getTimeCallback.AsStdFunction());
+    auto otherTimer = other.createSingleShotTimer();
+    uut->setOrderingKey(*otherTimer, 1000);
+}
+
+#ifdef __linux__
+TEST_F(TimerManagerTest, TimerFdDriverArmsEarliestExpiryTest)
+{
+    StrictMock<MockFunction<void(void)>> timerCallback;
+    auto uut = createUUT();
+    TimerFdDriver driver(*uut);
+    auto isReadable = [&driver]() {
+        pollfd readable{driver.fd(), POLLIN, 0};
+        return ::poll(&readable, 1, 0) == 1;
+    };
+    auto timer1 = uut->createSingleShotTimer();
+    auto timer2 = uut->createSingleShotTimer();
+    timer1->setTimeoutCallback(timerCallback.AsStdFunction());
+
+    // nothing runs, no wakeup
+    EXPECT_FALSE(isReadable());
+    timer2->start(10s);
+    timer1->start(5ms);
+    pollfd readable{driver.fd(), POLLIN, 0};
+    EXPECT_EQ(1, ::poll(&readable, 1, 1000));
+
+    m_currentTime += 5ms;
+    EXPECT_CALL(timerCallback, Call());
+    driver.onReadable();
+    Mock::VerifyAndClearExpectations(&timerCallback);
+    // rearmed to the 10s timer
+    EXPECT_FALSE(isReadable());
+
+    // paused the steady clock does not expire timers, fast forward does and rearms
+    timer1->start(50ms);
+    uut->pause();
+    EXPECT_EQ(0, ::poll(&readable, 1, 100));
+    EXPECT_CALL(timerCallback, Call());
+    uut->fastForward(50ms);
+    Mock::VerifyAndClearExpectations(&timerCallback);
+    uut->resume();
+    EXPECT_FALSE(isReadable());
+
+    // timers started by other threads are started by the next poll, which arms the timerfd for them
+    uut->enableCrossThreadCommands();
+    std::thread([&]() { timer1->start(1ms); }).join();
+    EXPECT_TRUE(isReadable());
+    driver.onReadable();
+    EXPECT_TRUE(timer1->isRunning());
+    EXPECT_EQ(1, ::poll(&readable, 1, 1000));
+    m_currentTime += 1ms;
+    EXPECT_CALL(timerCallback, Call());
+    driver.onReadable();
+    EXPECT_FALSE(isReadable());
+}
+#endif
+
+#if defined(__cpp_impl_coroutine)
+/** coroutine running eagerly until its first suspension, destroys itself at the end */
+struct DetachedCoroutine
+{
+    struct promise_type
+    {
+        DetachedCoroutine get_return_object()
+        {
+            return {};
+        }
+
+        std::suspend_never initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void() {}
+
+        void unhandled_exception()
+        {
+            std::terminate();
+        }
+    };
+};
+
+/** completes without suspending */
+struct ReadyAwaiter
+{
+    bool await_ready() const noexcept
+    {
+        return true;
+    }
+
+    void await_suspend(std::coroutine_handle<>) {}
+
+    int await_resume()
+    {
+        return 42;
+    }
+};
+
+/** awaitable through operator co_await */
+struct ReadyAwaitable
+{
+    ReadyAwaiter operator co_await() const
+    {
+        return {};
+    }
+};
+
+TEST(TimerCoroutinesTest, SleepForResumesFromPollWithoutAllocationTest)
+{
+    auto currentTime = 0ms;
+    auto uut = std::make_shared<TimerManager>([&currentTime]() { return currentTime; });
+    int wakeups = 0;
+    auto sleeper = [&]() -> DetachedCoroutine {
+        for (int sleep = 0; sleep < 5; ++sleep)
+        {
+            co_await sleepFor(*uut, 100ms);
+            ++wakeups;
+        }
+    };
+    sleeper();
+    uut->fastForward(100ms);
+
+    AllocationCounter counter;
+    uut->fastForward(350ms);
+    EXPECT_EQ(0u, counter.allocations());
+    EXPECT_EQ(4, wakeups);
+    // each sleep counts from the expire time of the previous one
+    EXPECT_EQ(50ms, uut->timeUntilNextExpiry());
+    currentTime += 50ms;
+    uut->poll();
+    EXPECT_EQ(5, wakeups);
+    EXPECT_EQ(TimerManager::noExpiry(), uut->timeUntilNextExpiry());
+}
+
+TEST(TimerCoroutinesTest, WithTimeoutTest)
+{
+    auto uut = std::make_shared<TimerManager>([]() { return 0ms; });
+    std::vector<bool> completed;
+    std::optional<int> result;
+    std::optional<int> awaitableResult;
+    auto waiter = [&]() -> DetachedCoroutine {
+        completed.push_back(co_await withTimeout(*uut, sleepFor(*uut, 50ms), 100ms));
+        // the timed out sleep is cancelled
+        completed.push_back(co_await withTimeout(*uut, sleepFor(*uut, 1s), 100ms));
+        auto sleep = sleepFor(*uut, 10ms);
+        completed.push_back(co_await withTimeout(*uut, sleep, 100ms));
+        result = co_await withTimeout(*uut, ReadyAwaiter(), 100ms);
+        awaitableResult = co_await withTimeout(*uut, ReadyAwaitable(), 100ms);
+        // a timed out lvalue sleep is cancelled as well, it must not resume the destroyed race while it lives on
+        auto longSleep = sleepFor(*uut, 1s);
+        completed.push_back(co_await withTimeout(*uut, longSleep, 100ms));
+        co_await sleepFor(*uut, 2s);
+        completed.push_back(true);
+    };
+    waiter();
+
+    uut->fastForward(50ms);
+    EXPECT_EQ(std::vector<bool>{true}, completed);
+    uut->fastForward(100ms);
+    EXPECT_EQ((std::vector<bool>{true, false}), completed);
+    EXPECT_EQ(10ms, uut->timeUntilNextExpiry());
+
+    uut->fastForward(10ms);
+    EXPECT_EQ((std::vector<bool>{true, false, true}), completed);
+    EXPECT_EQ(42, result);
+    EXPECT_EQ(100ms, uut->timeUntilNextExpiry());
+
+    EXPECT_EQ(42, awaitableResult);
+    uut->fastForward(100ms);
+    EXPECT_EQ((std::vector<bool>{true, false, true, false}), completed);
+    EXPECT_EQ(2s, uut->timeUntilNextExpiry());
+    uut->fastForward(2s);
+    EXPECT_EQ((std::vector<bool>{true, false, true, false, true}), completed);
+    EXPECT_EQ(TimerManager::noExpiry(), uut->timeUntilNextExpiry());
+}
+
+TEST(TimerCoroutinesTest, DestroyingSuspendedCoroutineCancelsTimersTest)
+{
+    auto uut = std::make_shared<TimerManager>([]() { return 0ms; });
+    struct Coroutine
+    {
+        struct promise_type
+        {
+            Coroutine get_return_object()
+            {
+                return Coroutine{std::coroutine_handle<promise_type>::from_promise(*this)};
+            }
+
+            std::suspend_never initial_suspend() noexcept
+            {
+                return {};
+            }
+
+            std::suspend_always final_suspend() noexcept
+            {
+                return {};
+            }
+
+            void return_void() {}
+
+            void unhandled_exception()
+            {
+                std::terminate();
+            }
+        };
+
+        std::coroutine_handle<promise_type> handle;
+    };
+    bool resumed = false;
+    auto waiter = [&]() -> Coroutine {
+        co_await withTimeout(*uut, sleepFor(*uut, 1s), 100ms);
+        resumed = true;
+    };
+    auto coroutine = waiter();
+    EXPECT_EQ(100ms, uut->timeUntilNextExpiry());
+    coroutine.handle.destroy();
+    EXPECT_EQ(TimerManager::noExpiry(), uut->timeUntilNextExpiry());
+    uut->fastForward(1s);
+    EXPECT_FALSE(resumed);
+}
+#endif
+
+TEST_F(TimerManagerTest, TimerIdTest)
+{
+    auto uut = createUUT();
+    std::vector<std::string> calls;
+    auto tick = uut->createTickTimerId();
+    auto singleShot = uut->createSingleShotTimerId();
+    EXPECT_NE(tick, singleShot);
+    EXPECT_FALSE(uut->isValid(TimerId()));
+    uut->setTimeoutCallback(tick, [&calls]() { calls.push_back("tick"); });
+    uut->setTimeoutCallback(singleShot, [&calls, &uut, &singleShot]() {
+        calls.push_back("singleShot");
+        // a timer may destroy itself in its callback
+        uut->destroy(singleShot);
+    });
+    uut->start(tick, 10ms);
+    uut->start(singleShot, 15ms);
+    EXPECT_EQ(10ms, uut->remaining(tick));
+
+    m_currentTime += 20ms;
+    uut->poll();
+    EXPECT_EQ((std::vector<std::string>{"tick", "singleShot", "tick"}), calls);
+    EXPECT_EQ(10ms, uut->remaining(tick));
+    EXPECT_FALSE(uut->isValid(singleShot));
+
+    // the freed slot is reused by a new timer, the stale handle does not reach it
+    auto reused = uut->createSingleShotTimerId();
+    EXPECT_NE(singleShot, reused);
+    uut->start(reused, 5ms);
+    uut->stop(singleShot);
+    uut->start(singleShot, 1ms);
+    EXPECT_TRUE(uut->isRunning(reused));
+    EXPECT_EQ(0ms, uut->remaining(singleShot));
+
+    uut->stop(tick);
+    EXPECT_FALSE(uut->isRunning(tick));
+    m_currentTime += 10ms;
+    uut->poll();
+    EXPECT_EQ(3u, calls.size());
+    EXPECT_FALSE(uut->isRunning(reused));
+    // the manager deletes the remaining timers of its handle table
+}
+
+TEST_F(TimerManagerTest, PriorityTest)
+{
+    auto uut = createUUT();
+    std::string calls;
+    std::vector<std::shared_ptr<ITimer>> timers;
+    auto add = [&](std::shared_ptr<ITimer> timer, char name, std::chrono::milliseconds duration) {
+        timer->setTimeoutCallback([&calls, name]() { calls += name; });
+        timer->start(duration);
+        timers.push_back(timer);
+    };
+    // a retransmit expiring later than the bulk cleanup goes first, expire time order holds within a class
+    add(uut->createSingleShotTimer(TimerPriority::low), 'c', 1ms);
+    add(uut->createSingleShotTimer(), 'n', 2ms);
+    add(uut->createSingleShotTimer(TimerPriority::high), 'R', 5ms);
+    add(uut->createSingleShotTimer(TimerPriority::high), 'r', 3ms);
+    m_currentTime += 10ms;
+    uut->poll();
+    EXPECT_EQ("rRnc", calls);
+
+    // a starving class gets its turn
+    calls.clear();
+    timers.clear();
+    uut->setStarvationLimit(2);
+    add(uut->createSingleShotTimer(TimerPriority::low), 'c', 1ms);
+    for (int index = 0; index < 5; ++index)
+    {
+        add(uut->createTickTimer(TimerPriority::high), 'r', 5ms);
+    }
+    m_currentTime += 10ms;
+    uut->poll();
+    EXPECT_EQ("rrcrrrrrrrr", calls);
+    EXPECT_EQ(5ms, timers.back()->getRemainingTime());
+
+    // the cleanup expired earlier, but runs after the retransmit: its time does not go back
+    timers.clear();
+    std::vector<std::chrono::milliseconds> times;
+    auto cleanup = uut->createSingleShotTimer(TimerPriority::low);
+    auto retransmit = uut->createSingleShotTimer(TimerPriority::high);
+    auto followUp = uut->createSingleShotTimer();
+    followUp->setTimeoutCallback([&times, &uut]() { times.push_back(uut->now()); });
+    cleanup->setTimeoutCallback([&times, &uut, &followUp]() {
+        times.push_back(uut->now());
+        followUp->start(10ms);
+    });
+    retransmit->setTimeoutCallback([&times, &uut]() { times.push_back(uut->now()); });
+    const auto start = uut->now();
+    cleanup->start(1ms);
+    retransmit->start(5ms);
+    m_currentTime += 10ms;
+    uut->poll();
+    EXPECT_EQ((std::vector<std::chrono::milliseconds>{start + 5ms, start + 5ms}), times);
+    EXPECT_EQ(5ms, followUp->getRemainingTime());
+}
+
+TEST_F(TimerManagerTest, VirtualTimeTest)
+{
+    auto uut = createUUT();
+    std::vector<std::string> calls;
+    std::vector<std::chrono::milliseconds> trace;
+    uut->setExpiryTrace([&trace](std::chrono::milliseconds expireTime, const ITimer&) { trace.push_back(expireTime); });
+    auto tick = uut->createTickTimer();
+    tick->setTimeoutCallback([&calls, &uut]() { calls.push_back("tick " + std::to_string(uut->now().count())); });
+    auto first = uut->createSingleShotTimer();
+    first->setTimeoutCallback([&calls, &uut]() { calls.push_back("first " + std::to_string(uut->now().count())); });
+    auto second = uut->createSingleShotTimer();
+    second->setTimeoutCallback([&calls, &uut]() { calls.push_back("second " + std::to_string(uut->now().count())); });
+    tick->start(20min);
+    first->start(30min);
+    second->start(50min);
+    const auto end = uut->now() + 1h;
+
+    // an hour passes in two clock reads, the pause and the resume
+    EXPECT_CALL(m_getTimeCallback, Call()).Times(2).WillRepeatedly(ReturnPointee(&m_currentTime));
+    uut->runUntil(end);
+    Mock::VerifyAndClearExpectations(&m_getTimeCallback);
+    EXPECT_CALL(m_getTimeCallback, Call()).WillRepeatedly(ReturnPointee(&m_currentTime));
+    EXPECT_EQ((std::vector<std::string>{"tick 1200000", "first 1800000", "tick 2400000", "second 3000000", "tick 3600000"}),
+              calls);
+    EXPECT_EQ((std::vector<std::chrono::milliseconds>{20min, 30min, 40min, 50min, 60min}), trace);
+    EXPECT_EQ(end, uut->now());
+    EXPECT_EQ(20min, tick->getRemainingTime());
+
+    calls.clear();
+    tick->stop();
+    first->start(5min);
+    EXPECT_EQ(1u, uut->runUntilIdle());
+    EXPECT_EQ((std::vector<std::string>{"first 3900000"}), calls);
+    EXPECT_FALSE(uut->step());
+    EXPECT_EQ(end + 5min, uut->now());
+}
+
+/** ShardedTimerManager polls from its own threads, so its clock is read concurrently */
+class ShardedTimerManagerTest : public Test
+{
+public:
+    std::shared_ptr<ShardedTimerManager> createUUT(std::size_t shardCount, bool workStealing = false)
+    {
+        return std::make_shared<ShardedTimerManager>(shardCount,
+                                                     [this]() { return std::chrono::milliseconds(m_currentTime.load()); },
+                                                     ShardedTimerManager::Placement::roundRobin,
+                                                     workStealing);
+    }
+
+    /** callback recording the thread it was called on */
+    std::function<void()> recordThread(int timer)
+    {
+        return [this, timer]() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_callbackThreads[timer] = std::this_thread::get_id();
+        };
+    }
+
+    std::map<int, std::thread::id> callbackThreads()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_callbackThreads;
+    }
+
+    std::atomic<std::chrono::milliseconds::rep> m_currentTime{0};
+    std::mutex m_mutex;
+    std::map<int, std::thread::id> m_callbackThreads;
+};
+
+TEST_F(ShardedTimerManagerTest, CallbacksRunOnOwningShardThreadTest)
+{
+    auto uut = createUUT(4);
+    ASSERT_EQ(4u, uut->shardCount());
+
+    std::vector<std::shared_ptr<ITimer>> timers;
+    for (int index = 0; index < 8; ++index)
+    {
+        timers.push_back(uut->createSingleShotTimer());
+        timers.back()->setTimeoutCallback(recordThread(index));
+        timers.back()->start(100ms);
+    }
+    auto hintedTimer = uut->createSingleShotTimer(5);
+    hintedTimer->setTimeoutCallback(recordThread(8));
+    hintedTimer->start(100ms);
+
+    uut->fastForward(99ms);
+    EXPECT_TRUE(callbackThreads().empty());
+    uut->fastForward(1ms);
+
+    auto threads = callbackThreads();
+    ASSERT_EQ(9u, threads.size());
+    for (int index = 0; index < 4; ++index)
+    {
+        EXPECT_NE(std::this_thread::get_id(), threads[index]);
+        EXPECT_EQ(threads[index], threads[index + 4]);
+        EXPECT_NE(threads[index], threads[(index + 1) % 4]);
+    }
+    EXPECT_EQ(threads[1], threads[8]);
+}
+
+TEST_F(ShardedTimerManagerTest, TimersOutliveTheManagerTest)
+{
+    auto uut = createUUT(2);
+    auto timer = uut->createTickTimer();
+    timer->start(500ms);
+    // the start is executed by the next poll of the shard
+    uut->poll();
+
+    m_currentTime += 100;
+    EXPECT_EQ(400ms, timer->getRemainingMilliseconds());
+    uut->fastForward(2ms);
+    uut->pause();
+    m_currentTime += 50;
+    EXPECT_EQ(398ms, timer->getRemainingMilliseconds());
+
+    // the time of the destroyed manager continues at the paused time
+    uut = nullptr;
+    EXPECT_EQ(398ms, timer->getRemainingMilliseconds());
+    m_currentTime += 98;
+    EXPECT_EQ(300ms, timer->getRemainingMilliseconds());
+    timer->touch();
+    EXPECT_EQ(500ms, timer->getRemainingMilliseconds());
+}
+
+TEST_F(ShardedTimerManagerTest, GroupsWrapAroundTheShardsTest)
+{
+    auto uut = createUUT(2);
+
+    // more groups than shards, round robin placement wraps around
+    std::vector<std::shared_ptr<ITimerGroup>> groups;
+    std::vector<std::shared_ptr<ITimer>> timers;
+    for (int index = 0; index < 5; ++index)
+    {
+        groups.push_back(uut->createTimerGroup());
+        timers.push_back(groups.back()->createSingleShotTimer());
+        timers.back()->setTimeoutCallback(recordThread(index));
+        timers.back()->start(100ms);
+    }
+    uut->fastForward(100ms);
+
+    auto threads = callbackThreads();
+    ASSERT_EQ(5u, threads.size());
+    EXPECT_EQ(threads[0], threads[2]);
+    EXPECT_EQ(threads[0], threads[4]);
+    EXPECT_NE(threads[0], threads[1]);
+}
+
+TEST_F(ShardedTimerManagerTest, PauseAndFastForwardApplyToAllShardsTest)
+{
+    auto uut = createUUT(3);
+
+    std::vector<std::shared_ptr<ITimer>> timers;
+    for (int index = 0; index < 3; ++index)
+    {
+        timers.push_back(uut->createSingleShotTimer());
+        timers.back()->setTimeoutCallback(recordThread(index));
+        timers.back()->start(100ms);
+    }
+    uut->poll();
+    EXPECT_EQ(100ms, uut->timeUntilNextExpiry());
+
+    uut->pause();
+    m_currentTime += 1000;
+    uut->poll();
+    EXPECT_TRUE(callbackThreads().empty());
+    uut->fastForward(100ms);
+    EXPECT_EQ(3u, callbackThreads().size());
+    EXPECT_EQ(ITimerManager::noExpiry(), uut->timeUntilNextExpiry());
+
+    m_callbackThreads.clear();
+    uut->resume();
+    for (auto& timer : timers)
+    {
+        timer->start(50ms);
+    }
+    uut->poll(); // starts from this thread count from the shard's next poll
+    m_currentTime += 49;
+    uut->poll();
+    EXPECT_TRUE(callbackThreads().empty());
+    m_currentTime += 1;
+    uut->poll();
+    EXPECT_EQ(3u, callbackThreads().size());
+}
+
+TEST_F(ShardedTimerManagerTest, IdleShardStealsQueuedCallbacksTest)
+{
+    auto uut = createUUT(2, true);
+
+    std::promise<void> othersDone;
+    auto blockingTimer = uut->createSingleShotTimer(0);
+    blockingTimer->setTimeoutCallback([&]() {
+        recordThread(0)();
+        // only returns when the callbacks queued behind this one run on another thread
+        othersDone.get_future().wait();
+    });
+    auto timer1 = uut->createSingleShotTimer(0);
+    timer1->setTimeoutCallback(recordThread(1));
+    auto timer2 = uut->createSingleShotTimer(0);
+    timer2->setTimeoutCallback([&]() {
+        recordThread(2)();
+        othersDone.set_value();
+    });
+
+    blockingTimer->start(100ms);
+    timer1->start(100ms);
+    timer2->start(100ms);
+    uut->fastForward(100ms);
+
+    auto threads = callbackThreads();
+    ASSERT_EQ(3u, threads.size());
+    EXPECT_NE(threads[0], threads[2]);
+}
+
+/** clock policy of the BasicTimerManager tests, moved by the test itself */
+struct TestClockPolicy
+{
+    static std::chrono::nanoseconds currentTime;
+
+    std::chrono::nanoseconds now() const
+    {
+        return currentTime;
+    }
+};
+
+std::chrono::nanoseconds TestClockPolicy::currentTime = 0ns;
+
+TEST(BasicTimerManagerTest, StaticClockPolicyTest)
+{
+    StrictMock<MockFunction<void(void)>> timerCallback;
+    TestClockPolicy::currentTime = 1000ms;
+    auto uut = std::make_shared<BasicTimerManager<TestClockPolicy>>();
+
+    auto timer = uut->createTickTimer();
+    timer->setTimeoutCallback(timerCallback.AsStdFunction());
+    timer->start(100ms);
+
+    // paused periods add up, the timer only sees the 60ms between them
+    TestClockPolicy::currentTime += 20ms;
+    uut->pause();
+    TestClockPolicy::currentTime += 500ms;
+    uut->resume();
+    TestClockPolicy::currentTime += 40ms;
+    uut->pause();
+    TestClockPolicy::currentTime += 500ms;
+    uut->resume();
+    EXPECT_EQ(40ms, timer->getRemainingMilliseconds());
+
+    EXPECT_CALL(timerCallback, Call());
+    TestClockPolicy::currentTime += 40ms;
+    uut->poll();
+    Mock::VerifyAndClearExpectations(&timerCallback);
+
+    // detached timers keep counting on the policy clock
+    uut = nullptr;
+    TestClockPolicy::currentTime += 30ms;
+    EXPECT_EQ(70ms, timer->getRemainingMilliseconds());
+}
+
+TEST(TimingWheelTimerManagerTest, CreateAndDeleteTimersAllocateOnlyTheTimerTest)
+{
+    auto uut = std::make_shared<TimingWheelTimerManager>([]() { return 0ms; });
+    std::vector<std::shared_ptr<ITimer>> timers;
+    timers.reserve(100);
+
+    // the registry of all timers is intrusive, make_shared is the only allocation per timer
+    AllocationCounter counter;
+    for (int index = 0; index < 100; ++index)
+    {
+        timers.push_back(index % 2 ? uut->createTickTimer() : uut->createSingleShotTimer());
+        timers.back()->start(1s);
+    }
+    timers.clear();
+    EXPECT_EQ(100u, counter.allocations());
+}
+
+TEST_F(TimerManagerTest, ScanKernelsExpireInDeadlineOrderTest)
+{
+    // 37 timers: full vectors and a scalar tail
+    std::vector<int> durations;
+    for (int index = 0; index < 37; ++index)
+    {
+        durations.push_back(1 + (index * 7919) % 23);
+    }
+    // started in reverse creation order, equal expire times fire in start order. Timer 5 is deleted
+    std::vector<int> expected;
+    for (int index = 0; index < 37; ++index)
+    {
+        if (index != 5)
+        {
+            expected.push_back(index);
+        }
+    }
+    std::sort(expected.begin(), expected.end(), [&durations](int left, int right) {
+        return durations[left] != durations[right] ? durations[left] < durations[right] : left > right;
+    });
+
+    for (auto kernel : {ScanTimerManager::Kernel::scalar, ScanTimerManager::Kernel::sse42, ScanTimerManager::Kernel::avx2})
+    {
+        m_currentTime = 0ms;
+        ScanTimerManager uut(m_getTimeCallback.AsStdFunction(), kernel);
+        EXPECT_NE(ScanTimerManager::Kernel::automatic, uut.kernel());
+        std::vector<int> fired;
+        std::vector<std::shared_ptr<ITimer>> timers;
+        for (std::size_t index = 0; index < durations.size(); ++index)
+        {
+            timers.push_back(uut.createSingleShotTimer());
+            timers.back()->setTimeoutCallback([&fired, index]() { fired.push_back(int(index)); });
+        }
+        for (auto index = durations.size(); index-- > 0;)
+        {
+            timers[index]->start(std::chrono::milliseconds(durations[index]));
+        }
+        // the last entry of the arrays moves into the freed one
+        timers[5].reset();
+        EXPECT_EQ(1ms, uut.timeUntilNextExpiry());
+
+        m_currentTime += 10ms;
+        uut.poll();
+        m_currentTime += 20ms;
+        uut.poll();
+        EXPECT_EQ(expected, fired) << int(uut.kernel());
+        EXPECT_EQ(ScanTimerManager::noExpiry(), uut.timeUntilNextExpiry());
+    }
+}
+
+TEST(StaticTimerManagerTest, ExpiresInDeadlineOrderWithoutAllocationTest)
+{
+    TestClockPolicy::currentTime = 1000ms;
+    StaticTimerManager<3, TestClockPolicy> uut;
+    std::array<char, 8> calls{};
+    std::size_t callCount = 0;
+    auto record = [&calls, &callCount](char call) { calls[callCount++ % calls.size()] = call; };
+
+    AllocationCounter counter;
+    auto tick = uut.createTickTimer();
+    auto first = uut.createSingleShotTimer();
+    auto second = uut.createSingleShotTimer();
+    EXPECT_FALSE(uut.createSingleShotTimer());
+    tick.setTimeoutCallback([&record]() { record('t'); });
+    // a timer started in a callback counts from the expire time
+    first.setTimeoutCallback([&record, &second]() {
+        record('f');
+        second.start(5ms);
+    });
+    second.setTimeoutCallback([&record]() { record('s'); });
+    tick.start(10ms);
+    first.start(10ms);
+    EXPECT_EQ(10ms, uut.timeUntilNextExpiry());
+
+    // paused periods do not count
+    uut.pause();
+    TestClockPolicy::currentTime += 100ms;
+    uut.resume();
+    EXPECT_EQ(10ms, tick.getRemainingTime());
+
+    TestClockPolicy::currentTime += 20ms;
+    uut.poll();
+    EXPECT_EQ(4u, callCount);
+    EXPECT_EQ((std::array<char, 8>{'t', 'f', 's', 't'}), calls);
+    EXPECT_FALSE(first.isRunning());
+    EXPECT_EQ(10ms, tick.getRemainingTime());
+
+    tick.stop();
+    uut.fastForward(1h);
+    EXPECT_EQ(4u, callCount);
+    EXPECT_EQ(StaticTimerManager<3>::noExpiry(), uut.timeUntilNextExpiry());
+    EXPECT_EQ(0u, counter.allocations());
+}
+
+TEST(BasicTimerManagerTest, MicrosecondResolutionTest)
+{
+    StrictMock<MockFunction<void(int)>> timerCallback;
+    TestClockPolicy::currentTime = 1s;
+    auto uut = std::make_shared<BasicTimerManager<TestClockPolicy, std::chrono::microseconds>>();
+
+    auto pacing = uut->createTickTimer();
+    pacing->setTimeoutCallback([&]() { timerCallback.Call(1); });
+    pacing->start(50us);
+    auto retransmission = uut->createSingleShotTimer();
+    retransmission->setTimeoutCallback([&]() { timerCallback.Call(2); });
+    retransmission->start(120us);
+    EXPECT_EQ(50us, uut->timeUntilNextExpiry());
+
+    Sequence seq;
+    EXPECT_CALL(timerCallback, Call(1)).Times(2).InSequence(seq);
+    EXPECT_CALL(timerCallback, Call(2)).InSequence(seq);
+    EXPECT_CALL(timerCallback, Call(1)).InSequence(seq);
+    // sub-microsecond clock parts are truncated
+    TestClockPolicy::currentTime += 150us + 999ns;
+    uut->poll();
+    EXPECT_EQ(50us, pacing->getRemainingTime());
+    EXPECT_EQ(0ms, pacing->getRemainingMilliseconds());
+
+    EXPECT_CALL(timerCallback, Call(1)).Times(1);
+    uut->fastForward(50us);
+}
+
+TEST(ChronoHelpersTest, OstreamTest)
 {
     EXPECT_EQ("300ns", testing::PrintToString(300ns));
     EXPECT_EQ("400us", testing::PrintToString(400us));
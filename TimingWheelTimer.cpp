@@ -0,0 +1,160 @@
+#include "TimingWheelTimer.hpp"
+#include "TimingWheelTimerManager.hpp"
+
+TimingWheelTimer::TimingWheelTimer(std::function<std::chrono::milliseconds(void)> callback,
+                                   bool singleShot,
+                                   MissedTickPolicy missedTickPolicy)
+: m_getTimeCallback(callback)
+, m_isSingleShot(singleShot)
+, m_missedTickPolicy(missedTickPolicy)
+{}
+
+TimingWheelTimer::~TimingWheelTimer()
+{
+	if (m_group)
+	{
+		m_group->removeTimer(*this);
+	}
+	if (m_manager)
+	{
+		m_manager->unregisterTimer(*this);
+	}
+}
+
+void TimingWheelTimer::stop()
+{
+	if (m_running)
+	{
+		m_running = false;
+		if (m_manager)
+		{
+			m_manager->unscheduleTimer(*this);
+		}
+	}
+}
+
+bool TimingWheelTimer::isRunning() const
+{
+	return m_running;
+}
+
+void TimingWheelTimer::setTimeoutCallback(std::function<void()> callback)
+{
+	// an empty std::function must not count as callback
+	setTimeoutCallback(callback ? InlineCallback(std::move(callback)) : InlineCallback());
+}
+
+void TimingWheelTimer::setTimeoutCallback(InlineCallback callback)
+{
+	m_timeoutCallback = std::move(callback);
+	m_timeoutCallbackReplaced = true;
+}
+
+void TimingWheelTimer::invokeTimeoutCallback()
+{
+	// see Timer::invokeTimeoutCallback
+	auto callback = std::move(m_timeoutCallback);
+	m_timeoutCallbackReplaced = false;
+	if (callback)
+	{
+		callback();
+	}
+	if (not m_timeoutCallbackReplaced)
+	{
+		m_timeoutCallback = std::move(callback);
+	}
+}
+
+void TimingWheelTimer::start(std::chrono::milliseconds duration)
+{
+	start(duration, 0ms);
+}
+
+void TimingWheelTimer::start(std::chrono::milliseconds duration, std::chrono::milliseconds slack)
+{
+	if (m_running or duration == 0ms)
+	{
+		return;
+	}
+	m_duration = duration;
+	m_slack = slack;
+	m_running = true;
+	m_expireTime = coalesceDeadline(now() + duration, slack);
+	if (m_manager)
+	{
+		m_manager->scheduleTimer(*this);
+	}
+}
+
+void TimingWheelTimer::startAt(std::chrono::milliseconds expireTime, std::chrono::milliseconds period)
+{
+	if (m_running or (not m_isSingleShot and period <= 0ms))
+	{
+		return;
+	}
+	// the following periods restart from expireTime without slack, so they stay on its grid
+	m_duration = m_isSingleShot ? startAtDuration(expireTime - now(), m_duration) : period;
+	m_slack = 0ms;
+	m_running = true;
+	m_expireTime = expireTime;
+	if (m_manager)
+	{
+		m_manager->scheduleTimer(*this);
+	}
+}
+
+void TimingWheelTimer::startAligned(std::chrono::milliseconds period, std::chrono::milliseconds phase)
+{
+	if (period <= 0ms)
+	{
+		return;
+	}
+	startAt(nextAlignedTime(now(), period, phase), period);
+}
+
+void TimingWheelTimer::restart(std::chrono::milliseconds duration)
+{
+	stop();
+	start(duration, m_slack);
+}
+
+void TimingWheelTimer::touch()
+{
+	restart(m_duration);
+}
+
+bool TimingWheelTimer::expired() const
+{
+	return m_expired;
+}
+
+std::chrono::milliseconds TimingWheelTimer::getRemainingTime() const
+{
+	if (m_running)
+	{
+		return m_expireTime - now();
+	}
+	else
+	{
+		return 0ms;
+	}
+}
+
+std::chrono::milliseconds TimingWheelTimer::now() const
+{
+	if (m_group and m_group->isPaused())
+	{
+		return m_group->m_pausedAt;
+	}
+	return m_getTimeCallback();
+}
+
+MissedTickPolicy TimingWheelTimer::missedTickPolicy() const
+{
+	return m_missedTickPolicy;
+}
+
+std::uint64_t TimingWheelTimer::missedTicks() const
+{
+	return m_missedTicks;
+}
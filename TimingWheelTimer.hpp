@@ -0,0 +1,90 @@
+#pragma once
+#include "ITimer.hpp"
+#include "TimerGroup.hpp"
+
+#include <memory>
+
+class TimingWheelTimerManager;
+
+/** Timer of TimingWheelTimerManager. It is linked into exactly one wheel slot while running. */
+class TimingWheelTimer : public ITimer, public std::enable_shared_from_this<TimingWheelTimer>
+{
+public:
+	TimingWheelTimer(std::function<std::chrono::milliseconds(void)>,
+	                 bool singleShot,
+	                 MissedTickPolicy missedTickPolicy = MissedTickPolicy::fireAll);
+
+	~TimingWheelTimer();
+
+	void stop() override;
+
+	using ITimer::setTimeoutCallback;
+
+	void setTimeoutCallback(std::function<void()> callback) override;
+
+	void setTimeoutCallback(InlineCallback callback) override;
+
+	void start(std::chrono::milliseconds duration) override;
+
+	void start(std::chrono::milliseconds duration, std::chrono::milliseconds slack) override;
+
+	using ITimer::startAt;
+
+	void startAt(std::chrono::milliseconds expireTime, std::chrono::milliseconds period) override;
+
+	using ITimer::startAligned;
+
+	void startAligned(std::chrono::milliseconds period, std::chrono::milliseconds phase) override;
+
+	/** moving a timer in the wheel is O(1), so restart is eager */
+	void restart(std::chrono::milliseconds duration) override;
+
+	void touch() override;
+
+	bool expired() const override;
+
+	bool isRunning() const override;
+
+	std::chrono::milliseconds getRemainingTime() const override;
+
+	MissedTickPolicy missedTickPolicy() const override;
+
+	std::uint64_t missedTicks() const override;
+
+	using Group = BasicTimerGroup<TimingWheelTimerManager, TimingWheelTimer, std::chrono::milliseconds>;
+
+	friend class TimingWheelTimerManager;
+	friend Group;
+
+private:
+	/** time of the manager, standing still while the group is paused */
+	std::chrono::milliseconds now() const;
+
+	/** Calls the timeout callback, which may replace itself meanwhile */
+	void invokeTimeoutCallback();
+
+	InlineCallback m_timeoutCallback;
+	bool m_timeoutCallbackReplaced = false; // set when the callback was replaced while it was running
+	std::function<std::chrono::milliseconds(void)> m_getTimeCallback = nullptr;
+	bool m_running = false;
+	bool m_expired = false;
+	const bool m_isSingleShot = false;
+	const MissedTickPolicy m_missedTickPolicy = MissedTickPolicy::fireAll;
+	std::uint64_t m_missedTicks = 0; // of the current expiry
+	std::chrono::milliseconds m_expireTime = 0ms;
+	std::chrono::milliseconds m_duration = 0ms;
+	std::chrono::milliseconds m_slack = 0ms;
+
+	// scheduling state, owned by the manager. m_manager is reset when the manager is deleted before the timer
+	TimingWheelTimerManager* m_manager = nullptr;
+	TimingWheelTimer* m_previousTimer = nullptr; // intrusive list of all timers of the manager
+	TimingWheelTimer* m_nextTimer = nullptr;
+	TimingWheelTimer* m_previous = nullptr; // neighbours in the wheel slot
+	TimingWheelTimer* m_next = nullptr;
+	unsigned m_level = 0;     // wheel level of the slot, see TimingWheelTimerManager
+	unsigned m_slotIndex = 0; // slot in the level
+	bool m_linked = false;
+	Group* m_group = nullptr;
+	TimingWheelTimer* m_previousInGroup = nullptr;
+	TimingWheelTimer* m_nextInGroup = nullptr;
+};
@@ -0,0 +1,492 @@
+#include "TimingWheelTimerManager.hpp"
+#include "TimingWheelTimer.hpp"
+
+#include <algorithm>
+#include <limits>
+
+constexpr unsigned TimingWheelTimerManager::slotBits;
+constexpr unsigned TimingWheelTimerManager::slotsPerLevel;
+constexpr unsigned TimingWheelTimerManager::levels;
+constexpr unsigned TimingWheelTimerManager::dueLevel;
+constexpr unsigned TimingWheelTimerManager::overflowLevel;
+
+namespace {
+
+constexpr std::uint64_t lowBitsMask(unsigned bits)
+{
+    return (std::uint64_t(1) << bits) - 1;
+}
+
+unsigned highestBit(std::uint64_t value)
+{
+    return 63 - __builtin_clzll(value);
+}
+
+unsigned lowestBit(std::uint64_t value)
+{
+    return __builtin_ctzll(value);
+}
+
+} // namespace
+
+TimingWheelTimerManager::TimingWheelTimerManager(SteadyTickCallbackType steadyTickProvider)
+: m_timeBase(steadyTickProvider)
+, m_steadyTickCallback([this]() { return m_timeBase.now(); })
+, m_origin(m_timeBase.now())
+{
+    m_occupied.fill(0);
+}
+
+TimingWheelTimerManager::~TimingWheelTimerManager()
+{
+    // remove local dependencies in created timers, see TimerManager
+    SteadyTickCallbackType replacementSteadyTickCallback = [clock = m_timeBase.detachedClock()]() {
+        return clock.now();
+    };
+
+    auto timer = m_firstTimer;
+    while (timer)
+    {
+        auto next = timer->m_nextTimer;
+        timer->m_getTimeCallback = replacementSteadyTickCallback;
+        timer->m_manager = nullptr;
+        timer->m_linked = false;
+        timer->m_previousTimer = nullptr;
+        timer->m_nextTimer = nullptr;
+        timer = next;
+    }
+    m_firstTimer = nullptr;
+    for (auto group = m_firstGroup; group; group = group->m_nextGroup)
+    {
+        group->m_manager = nullptr;
+    }
+    m_firstGroup = nullptr;
+}
+
+std::shared_ptr<ITimer> TimingWheelTimerManager::createSingleShotTimer()
+{
+    return createTimer(true);
+}
+
+std::shared_ptr<ITimer> TimingWheelTimerManager::createTickTimer(MissedTickPolicy policy)
+{
+    return createTimer(false, policy);
+}
+
+std::shared_ptr<TimingWheelTimer> TimingWheelTimerManager::createTimer(bool singleShot, MissedTickPolicy policy)
+{
+    auto timer = std::make_shared<TimingWheelTimer>(m_steadyTickCallback, singleShot, policy);
+    timer->m_manager = this;
+    timer->m_nextTimer = m_firstTimer;
+    if (m_firstTimer)
+    {
+        m_firstTimer->m_previousTimer = timer.get();
+    }
+    m_firstTimer = timer.get();
+    return timer;
+}
+
+std::shared_ptr<ITimerGroup> TimingWheelTimerManager::createTimerGroup()
+{
+    return std::shared_ptr<Group>(new Group(*this), Group::Deleter());
+}
+
+std::shared_ptr<ITimer> TimingWheelTimerManager::createGroupTimer(bool singleShot, MissedTickPolicy policy, Group& group)
+{
+    auto timer = createTimer(singleShot, policy);
+    group.addTimer(*timer);
+    return timer;
+}
+
+void TimingWheelTimerManager::shiftTimer(TimingWheelTimer& timer, std::chrono::milliseconds shift)
+{
+    timer.m_expireTime += shift;
+    insert(timer);
+}
+
+bool TimingWheelTimerManager::postGroupOperation(Group&, TimerGroupOperation)
+{
+    return false;
+}
+
+void TimingWheelTimerManager::registerGroup(Group& group)
+{
+    group.m_previousGroup = nullptr;
+    group.m_nextGroup = m_firstGroup;
+    if (m_firstGroup)
+    {
+        m_firstGroup->m_previousGroup = &group;
+    }
+    m_firstGroup = &group;
+}
+
+void TimingWheelTimerManager::unregisterGroup(Group& group)
+{
+    if (group.m_previousGroup)
+    {
+        group.m_previousGroup->m_nextGroup = group.m_nextGroup;
+    }
+    else
+    {
+        m_firstGroup = group.m_nextGroup;
+    }
+    if (group.m_nextGroup)
+    {
+        group.m_nextGroup->m_previousGroup = group.m_previousGroup;
+    }
+    group.m_manager = nullptr;
+}
+
+void TimingWheelTimerManager::scheduleTimer(TimingWheelTimer& timer)
+{
+    // timers of paused groups are running, but not scheduled
+    if (timer.m_group and timer.m_group->isPaused())
+    {
+        return;
+    }
+    insert(timer);
+}
+
+void TimingWheelTimerManager::unscheduleTimer(TimingWheelTimer& timer)
+{
+    unlink(timer);
+}
+
+void TimingWheelTimerManager::unregisterTimer(TimingWheelTimer& timer)
+{
+    unlink(timer);
+    if (timer.m_previousTimer)
+    {
+        timer.m_previousTimer->m_nextTimer = timer.m_nextTimer;
+    }
+    else
+    {
+        m_firstTimer = timer.m_nextTimer;
+    }
+    if (timer.m_nextTimer)
+    {
+        timer.m_nextTimer->m_previousTimer = timer.m_previousTimer;
+    }
+    timer.m_manager = nullptr;
+}
+
+void TimingWheelTimerManager::fastForward(std::chrono::milliseconds milliseconds)
+{
+    // this is not allowed when polling is active
+    if (m_timeBase.isPolling())
+    {
+        return;
+    }
+    m_timeBase.fastForward(milliseconds);
+    poll();
+}
+
+void TimingWheelTimerManager::pause()
+{
+    // this is not allowed when polling is active
+    if (m_timeBase.isPolling())
+    {
+        return;
+    }
+    m_timeBase.pause();
+}
+
+void TimingWheelTimerManager::resume()
+{
+    // this is not allowed when polling is active
+    if (m_timeBase.isPolling())
+    {
+        return;
+    }
+    m_timeBase.resume();
+}
+
+std::chrono::milliseconds TimingWheelTimerManager::now() const
+{
+    return m_timeBase.now();
+}
+
+std::chrono::milliseconds TimingWheelTimerManager::timeUntilNextExpiry() const
+{
+    if (m_due.first)
+    {
+        return 0ms;
+    }
+    if (not m_nextExpireTimeKnown)
+    {
+        // the earliest occupied slot holds the earliest timer, but slots above level 0 are not sorted
+        const Slot* earliest = &m_overflow;
+        unsigned level = 0;
+        if (findNextSlot(level))
+        {
+            earliest = &m_wheel[level][(slotStartTicks(level) >> (level * slotBits)) & lowBitsMask(slotBits)];
+        }
+        if (not earliest->first)
+        {
+            return noExpiry();
+        }
+        m_nextExpireTime = earliest->first->m_expireTime;
+        for (auto timer = earliest->first; timer; timer = timer->m_next)
+        {
+            m_nextExpireTime = std::min(m_nextExpireTime, timer->m_expireTime);
+        }
+        m_nextExpireTimeKnown = true;
+    }
+    return std::max(0ms, m_nextExpireTime - m_timeBase.now());
+}
+
+void TimingWheelTimerManager::waitAndPoll(std::chrono::milliseconds maxWait)
+{
+    // waiting inside a callback would only delay the running poll
+    if (m_timeBase.isPolling())
+    {
+        return;
+    }
+    // while paused the steady clock does not move our timers, only fast forward does
+    auto timeout = m_timeBase.isPaused() ? maxWait : std::min(maxWait, timeUntilNextExpiry());
+    m_wakeupSignal.waitFor(timeout);
+    poll();
+}
+
+void TimingWheelTimerManager::wakeup()
+{
+    m_wakeupSignal.notify();
+}
+
+void TimingWheelTimerManager::poll()
+{
+    // only one poll at the same time allowed
+    if (m_timeBase.isPolling())
+    {
+        return;
+    }
+    const auto currentTime = m_timeBase.now();
+    const auto targetTicks = toTicks(currentTime);
+    // see TimerManager::poll: timers (re)started in callbacks use the expire time of the current timer as reference
+    m_timeBase.beginPoll();
+
+    // Fire everything the wheel has collected, then advance to the next occupied slot.
+    // Timers restarted in callbacks expire after the current wheel tick, so they are found by a later advance.
+    while (m_due.first or advanceToNextSlot(targetTicks))
+    {
+        if (not m_due.first)
+        {
+            continue;
+        }
+        // keep timer alive during callback, even when the callback drops the last reference
+        auto timer = m_due.first->shared_from_this();
+        m_timeBase.setPollTimeStamp(timer->m_expireTime);
+        timer->stop();
+        auto restartTime = timer->m_expireTime;
+        if (not timer->m_isSingleShot)
+        {
+            restartTime = tickRestartTime(timer->m_missedTickPolicy, timer->m_expireTime, currentTime, timer->m_duration,
+                                          timer->m_missedTicks);
+        }
+        timer->invokeTimeoutCallback();
+        if (not timer->m_isSingleShot)
+        {
+            m_timeBase.setPollTimeStamp(restartTime);
+            timer->start(timer->m_duration, timer->m_slack);
+        }
+    }
+    m_timeBase.endPoll();
+}
+
+TimingWheelTimerManager::Slot& TimingWheelTimerManager::slot(unsigned level, unsigned slotIndex)
+{
+    if (level == dueLevel)
+    {
+        return m_due;
+    }
+    if (level == overflowLevel)
+    {
+        return m_overflow;
+    }
+    return m_wheel[level][slotIndex];
+}
+
+void TimingWheelTimerManager::link(TimingWheelTimer& timer, unsigned level, unsigned slotIndex)
+{
+    auto& target = slot(level, slotIndex);
+    timer.m_level = level;
+    timer.m_slotIndex = slotIndex;
+    timer.m_previous = target.last;
+    timer.m_next = nullptr;
+    timer.m_linked = true;
+    if (target.last)
+    {
+        target.last->m_next = &timer;
+    }
+    else
+    {
+        target.first = &timer;
+    }
+    target.last = &timer;
+    if (level < levels)
+    {
+        m_occupied[level] |= std::uint64_t(1) << slotIndex;
+    }
+    if (m_nextExpireTimeKnown and timer.m_expireTime < m_nextExpireTime)
+    {
+        m_nextExpireTime = timer.m_expireTime;
+    }
+}
+
+void TimingWheelTimerManager::unlink(TimingWheelTimer& timer)
+{
+    if (not timer.m_linked)
+    {
+        return;
+    }
+    auto& source = slot(timer.m_level, timer.m_slotIndex);
+    if (timer.m_previous)
+    {
+        timer.m_previous->m_next = timer.m_next;
+    }
+    else
+    {
+        source.first = timer.m_next;
+    }
+    if (timer.m_next)
+    {
+        timer.m_next->m_previous = timer.m_previous;
+    }
+    else
+    {
+        source.last = timer.m_previous;
+    }
+    if (timer.m_level < levels and not source.first)
+    {
+        m_occupied[timer.m_level] &= ~(std::uint64_t(1) << timer.m_slotIndex);
+    }
+    if (timer.m_expireTime == m_nextExpireTime)
+    {
+        m_nextExpireTimeKnown = false;
+    }
+    timer.m_previous = nullptr;
+    timer.m_next = nullptr;
+    timer.m_linked = false;
+}
+
+void TimingWheelTimerManager::insert(TimingWheelTimer& timer)
+{
+    const auto expireTicks = toTicks(timer.m_expireTime);
+    if (expireTicks <= m_wheelTicks)
+    {
+        link(timer, dueLevel, 0);
+        return;
+    }
+    // the highest 6 bit digit in which expire tick and wheel tick differ selects the level.
+    // Expire tick is later, so its digit in that level is ahead of the wheel.
+    const auto level = highestBit(expireTicks ^ m_wheelTicks) / slotBits;
+    if (level >= levels)
+    {
+        link(timer, overflowLevel, 0);
+        return;
+    }
+    link(timer, level, (expireTicks >> (level * slotBits)) & lowBitsMask(slotBits));
+}
+
+void TimingWheelTimerManager::rehash(Slot slot)
+{
+    auto timer = slot.first;
+    while (timer)
+    {
+        auto next = timer->m_next;
+        timer->m_linked = false;
+        insert(*timer);
+        timer = next;
+    }
+}
+
+std::uint64_t TimingWheelTimerManager::toTicks(std::chrono::milliseconds time) const
+{
+    if (time <= m_origin)
+    {
+        return 0;
+    }
+    return static_cast<std::uint64_t>((time - m_origin).count());
+}
+
+bool TimingWheelTimerManager::findNextSlot(unsigned& level) const
+{
+    // slots ahead of the wheel in lower levels always start before those in higher levels
+    for (level = 0; level < levels; ++level)
+    {
+        if (m_occupied[level] & aheadOfWheel(level))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::uint64_t TimingWheelTimerManager::aheadOfWheel(unsigned level) const
+{
+    const auto wheelDigit = (m_wheelTicks >> (level * slotBits)) & lowBitsMask(slotBits);
+    return (wheelDigit + 1 < slotsPerLevel) ? ~lowBitsMask(wheelDigit + 1) : 0;
+}
+
+std::uint64_t TimingWheelTimerManager::slotStartTicks(unsigned level) const
+{
+    const auto shift = level * slotBits;
+    const auto levelBase = m_wheelTicks & ~lowBitsMask(shift + slotBits);
+    return levelBase | (std::uint64_t(lowestBit(m_occupied[level] & aheadOfWheel(level))) << shift);
+}
+
+bool TimingWheelTimerManager::advanceToNextSlot(std::uint64_t targetTicks)
+{
+    auto nextTicks = std::numeric_limits<std::uint64_t>::max();
+    unsigned slotLevel = 0;
+    if (findNextSlot(slotLevel))
+    {
+        nextTicks = slotStartTicks(slotLevel);
+    }
+    if (m_overflow.first)
+    {
+        const auto shift = levels * slotBits;
+        nextTicks = std::min(nextTicks, ((m_wheelTicks >> shift) + 1) << shift);
+    }
+
+    if (nextTicks > targetTicks)
+    {
+        m_wheelTicks = std::max(m_wheelTicks, targetTicks);
+        return false;
+    }
+    m_wheelTicks = nextTicks;
+
+    // cascade coarse slots starting at this tick into finer levels, then collect the finest slot
+    if ((m_wheelTicks & lowBitsMask(levels * slotBits)) == 0 and m_overflow.first)
+    {
+        auto overflow = m_overflow;
+        m_overflow = Slot();
+        rehash(overflow);
+    }
+    for (unsigned level = levels - 1; level > 0; --level)
+    {
+        const auto shift = level * slotBits;
+        if ((m_wheelTicks & lowBitsMask(shift)) != 0)
+        {
+            continue;
+        }
+        const auto slotIndex = (m_wheelTicks >> shift) & lowBitsMask(slotBits);
+        auto& cascading = m_wheel[level][slotIndex];
+        if (cascading.first)
+        {
+            auto timers = cascading;
+            cascading = Slot();
+            m_occupied[level] &= ~(std::uint64_t(1) << slotIndex);
+            rehash(timers);
+        }
+    }
+    auto& reached = m_wheel[0][m_wheelTicks & lowBitsMask(slotBits)];
+    if (reached.first)
+    {
+        auto timers = reached;
+        reached = Slot();
+        m_occupied[0] &= ~(std::uint64_t(1) << (m_wheelTicks & lowBitsMask(slotBits)));
+        rehash(timers); // all of them are due at the current tick
+    }
+    return true;
+}
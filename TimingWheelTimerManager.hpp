@@ -0,0 +1,131 @@
+#pragma once
+
+#include "ITimerManager.hpp"
+#include "TimeBase.hpp"
+#include "TimerGroup.hpp"
+#include "WakeupSignal.hpp"
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+class TimingWheelTimer;
+
+extern std::chrono::milliseconds getChronoSteadyClockTicks(void);
+
+/** Timer manager based on hashed hierarchical timing wheels, meant for very large timer populations
+ * where most timers are stopped or restarted long before they expire.
+ * Start, stop and restart are O(1). poll() costs time proportional to the occupied slots it advances over
+ * plus the timers it fires; empty slots are skipped using a per level occupancy bitmap.
+ *
+ * There are 6 levels of 64 slots. A slot of level n spans 64^n milliseconds. Timers are hashed by their absolute
+ * expire time into the lowest level whose slot range does not contain the current wheel time.
+ * Precision at wheel boundaries: a timer waiting in a coarse slot is cascaded into a finer level exactly when
+ * the wheel reaches the first millisecond of that slot, so coarse levels never round expire times. Every timer
+ * fires in the poll covering its expire millisecond, exactly like with TimerManager. The price is that a timer
+ * is re-hashed at most once per level it passes on its way down. Timers more than 64^6 ms (about 795 days) ahead
+ * wait in an overflow list which is re-hashed each time the top level wraps.
+ * Timers expiring in the same millisecond fire in the order they were started. */
+class TimingWheelTimerManager : public ITimerManager
+{
+public:
+    using SteadyTickCallbackType = TimeBase::SteadyTickCallbackType;
+
+    TimingWheelTimerManager(SteadyTickCallbackType steadyTickProvider = getChronoSteadyClockTicks);
+
+    ~TimingWheelTimerManager();
+
+    std::shared_ptr<ITimer> createSingleShotTimer() override;
+
+    std::shared_ptr<ITimer> createTickTimer(MissedTickPolicy policy = MissedTickPolicy::fireAll) override;
+
+    std::shared_ptr<ITimerGroup> createTimerGroup() override;
+
+    void fastForward(std::chrono::milliseconds milliseconds) override;
+
+    void poll() override;
+
+    void pause() override;
+
+    void resume() override;
+
+    std::chrono::milliseconds timeUntilNextExpiry() const override;
+
+    /** current time of the manager, the time line of ITimer::startAt */
+    std::chrono::milliseconds now() const;
+
+    void waitAndPoll(std::chrono::milliseconds maxWait) override;
+
+    void wakeup() override;
+
+private:
+    using Group = BasicTimerGroup<TimingWheelTimerManager, TimingWheelTimer, std::chrono::milliseconds>;
+    friend class TimingWheelTimer;
+    friend Group;
+
+    static constexpr unsigned slotBits = 6;
+    static constexpr unsigned slotsPerLevel = 1u << slotBits;
+    static constexpr unsigned levels = 6;
+    static constexpr unsigned dueLevel = levels;          // timers reached by the wheel, waiting for their callback
+    static constexpr unsigned overflowLevel = levels + 1; // timers beyond the range of the top level
+
+    struct Slot
+    {
+        TimingWheelTimer* first = nullptr;
+        TimingWheelTimer* last = nullptr;
+    };
+
+    TimingWheelTimerManager(const TimingWheelTimerManager&) = delete;
+    TimingWheelTimerManager(TimingWheelTimerManager&&) = delete;
+
+    std::shared_ptr<TimingWheelTimer> createTimer(bool singleShot, MissedTickPolicy policy = MissedTickPolicy::fireAll);
+
+    std::shared_ptr<ITimer> createGroupTimer(bool singleShot, MissedTickPolicy policy, Group& group);
+
+    /** called by a resumed group, moves the expire time of a running timer by the paused period and inserts it */
+    void shiftTimer(TimingWheelTimer& timer, std::chrono::milliseconds shift);
+
+    /** the timing wheel is single threaded, group operations are never queued */
+    bool postGroupOperation(Group& group, TimerGroupOperation operation);
+
+    void registerGroup(Group& group);
+    void unregisterGroup(Group& group);
+
+    /** called by timer when it was started. Hashes it into its slot */
+    void scheduleTimer(TimingWheelTimer& timer);
+
+    /** called by timer when it was stopped. Unlinks it from its slot */
+    void unscheduleTimer(TimingWheelTimer& timer);
+
+    /** called by timer on destruction */
+    void unregisterTimer(TimingWheelTimer& timer);
+
+    Slot& slot(unsigned level, unsigned slotIndex);
+    void link(TimingWheelTimer& timer, unsigned level, unsigned slotIndex);
+    void unlink(TimingWheelTimer& timer);
+    void insert(TimingWheelTimer& timer);
+    void rehash(Slot slot);
+    std::uint64_t toTicks(std::chrono::milliseconds time) const;
+
+    /** level of the earliest slot ahead of the wheel holding timers. Returns false when the wheel is empty */
+    bool findNextSlot(unsigned& level) const;
+    std::uint64_t aheadOfWheel(unsigned level) const;
+    std::uint64_t slotStartTicks(unsigned level) const;
+
+    /** move the wheel to the next slot holding timers and cascade/collect them, but not beyond targetTicks.
+     * Returns false when no such slot exists, the wheel is at targetTicks then. */
+    bool advanceToNextSlot(std::uint64_t targetTicks);
+
+    TimeBase m_timeBase;
+    WakeupSignal m_wakeupSignal;
+    SteadyTickCallbackType m_steadyTickCallback; // handed to timers, reads m_timeBase
+    TimingWheelTimer* m_firstTimer = nullptr;    // intrusive list of all living timers, needed to detach them on destruction
+    Group* m_firstGroup = nullptr;               // intrusive list of all living groups, detached on destruction
+    std::chrono::milliseconds m_origin;          // time of wheel tick 0
+    std::uint64_t m_wheelTicks = 0;              // all timers up to this tick have been moved to m_due
+    std::array<std::array<Slot, slotsPerLevel>, levels> m_wheel;
+    std::array<std::uint64_t, levels> m_occupied; // bit n set when slot n of the level holds timers
+    Slot m_due;
+    Slot m_overflow;
+    mutable std::chrono::milliseconds m_nextExpireTime = 0ms; // cached for timeUntilNextExpiry
+    mutable bool m_nextExpireTimeKnown = false;
+};
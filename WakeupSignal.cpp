@@ -0,0 +1,26 @@
+#include "WakeupSignal.hpp"
+
+void WakeupSignal::notify()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_notified = true;
+    }
+    m_condition.notify_one();
+}
+
+void WakeupSignal::prepareWait()
+{
+    m_waiting.store(true, std::memory_order_relaxed);
+    // pairs with the fence in notifyWaiter: either the producer sees m_waiting or we see its work
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void WakeupSignal::notifyWaiter()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_waiting.load(std::memory_order_relaxed))
+    {
+        notify();
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+/** Thread-safe one shot wakeup for a blocking wait. A notification sent while nobody waits is kept
+ * and ends the next wait immediately. */
+class WakeupSignal
+{
+public:
+    /** block until notified or timeout elapsed. The maximum of the duration type waits without timeout */
+    template <typename Rep, typename Period>
+    void waitFor(std::chrono::duration<Rep, Period> timeout)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        auto notified = [this]() { return m_notified; };
+        if (timeout == std::chrono::duration<Rep, Period>::max())
+        {
+            m_condition.wait(lock, notified);
+        }
+        else
+        {
+            m_condition.wait_for(lock, timeout, notified);
+        }
+        m_notified = false;
+        m_waiting.store(false, std::memory_order_relaxed);
+    }
+
+    void notify();
+
+    /** announce the next waitFor(). Must be followed by a check for pending work and then waitFor() */
+    void prepareWait();
+
+    /** lock-free variant of notify() for producers which published work beforehand.
+     * Only notifies when a waiter announced itself with prepareWait(), it sees the published work otherwise. */
+    void notifyWaiter();
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_notified = false;
+    std::atomic<bool> m_waiting{false};
+};